@@ -0,0 +1,143 @@
+/*
+ * herramientas/traza2json.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Herramienta de la maquina anfitriona que convierte la salida de
+ * usuario/volcar_traza (lineas "EV secuencia tick tipo id arg valor",
+ * posiblemente mezcladas con el resto de la consola) en un fichero JSON
+ * con el formato de eventos de chrome://tracing o Perfetto.
+ *
+ * Cada proceso se muestra como un "pid" con dos hilos: el 0 con los
+ * intervalos en que ocupa la UCP y el 1 con sus llamadas al sistema.
+ * Las interrupciones aparecen como eventos instantaneos del pid -1.
+ *
+ * Uso: traza2json < consola.txt > traza.json
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "const.h"
+#include "compartido.h"
+
+#define US_POR_TICK (1000000/TICK)
+#define NUM_NOMBRES(tabla) ((int)(sizeof(tabla)/sizeof(tabla[0])))
+
+static const char *nombre_bloqueo[]={[BLOQUEO_DORMIR]="dormir",
+	[BLOQUEO_MUTEX]="mutex", [BLOQUEO_RR]="rodaja",
+	[BLOQUEO_TERMINAL]="terminal", [BLOQUEO_MUTEX_LIBRE]="mutex_libre",
+	[BLOQUEO_HIJO]="hijo", [BLOQUEO_SEMAFORO]="semaforo",
+	[BLOQUEO_CONDICION]="condicion", [BLOQUEO_LECTURA]="lectura",
+	[BLOQUEO_ESCRITURA]="escritura", [BLOQUEO_BARRERA]="barrera"};
+static const char *nombre_vector[]={"excepcion aritmetica", "excepcion de memoria",
+	"reloj", "terminal", "llamada", "software"};
+
+static int *vistos=NULL;
+static int num_vistos=0;
+static int primero=1;
+
+/* Emite el separador entre eventos del vector JSON */
+static void separar(){
+	if (!primero)
+		printf(",\n");
+	primero=0;
+}
+
+/* Emite el nombre del proceso la primera vez que aparece */
+static void nombrar_proceso(int id){
+	int i;
+
+	for (i=0; i<num_vistos; i++)
+		if (vistos[i]==id)
+			return;
+	vistos=realloc(vistos, (num_vistos+1)*sizeof(int));
+	if (vistos==NULL){
+		perror("traza2json");
+		exit(1);
+	}
+	vistos[num_vistos++]=id;
+
+	separar();
+	if (id<0)
+		printf("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":-1,"
+			"\"args\":{\"name\":\"kernel\"}}");
+	else
+		printf("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,"
+			"\"args\":{\"name\":\"proceso %d\"}}", id, id);
+}
+
+static const char *nombre(const char **tabla, int num, int i){
+	return (i>=0 && i<num) ? tabla[i] : "?";
+}
+
+int main(){
+	char linea[256];
+	char *p;
+	evento_traza ev;
+	unsigned long ultimo_tick=0, orden=0, ts;
+
+	printf("[\n");
+	while (fgets(linea, sizeof(linea), stdin)){
+		if ((p=strstr(linea, "EV "))==NULL)
+			continue;
+		if (sscanf(p, "EV %lu %lu %d %d %d %ld", &ev.secuencia, &ev.tick,
+				&ev.tipo, &ev.id, &ev.arg, &ev.valor)!=6)
+			continue;
+
+		/* los eventos de un mismo tick se separan 1us para conservar el orden */
+		orden = (ev.tick==ultimo_tick) ? orden+1 : 0;
+		ultimo_tick=ev.tick;
+		ts=ev.tick*US_POR_TICK+orden;
+
+		switch (ev.tipo){
+		case EV_CAMBIO:
+			if (ev.id>=0){
+				nombrar_proceso(ev.id);
+				separar();
+				printf("{\"ph\":\"E\",\"name\":\"UCP\",\"pid\":%d,\"tid\":0,"
+					"\"ts\":%lu}", ev.id, ts);
+			}
+			nombrar_proceso(ev.arg);
+			separar();
+			printf("{\"ph\":\"B\",\"name\":\"UCP\",\"pid\":%d,\"tid\":0,"
+				"\"ts\":%lu}", ev.arg, ts);
+			break;
+		case EV_BLOQUEO:
+		case EV_DESPERTAR:
+			nombrar_proceso(ev.id);
+			separar();
+			printf("{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s %s\",\"pid\":%d,"
+				"\"tid\":0,\"ts\":%lu}",
+				ev.tipo==EV_BLOQUEO ? "bloqueo" : "despertar",
+				nombre(nombre_bloqueo, NUM_NOMBRES(nombre_bloqueo), ev.arg), ev.id, ts);
+			break;
+		case EV_LLAMADA:
+			nombrar_proceso(ev.id);
+			separar();
+			printf("{\"ph\":\"B\",\"name\":\"llamada %d\",\"pid\":%d,"
+				"\"tid\":1,\"ts\":%lu}", ev.arg, ev.id, ts);
+			break;
+		case EV_FIN_LLAMADA:
+			nombrar_proceso(ev.id);
+			separar();
+			printf("{\"ph\":\"E\",\"pid\":%d,\"tid\":1,\"ts\":%lu,"
+				"\"args\":{\"resultado\":%ld}}", ev.id, ts, ev.valor);
+			break;
+		case EV_INTERRUPCION:
+			nombrar_proceso(-1);
+			separar();
+			printf("{\"ph\":\"i\",\"s\":\"p\",\"name\":\"%s\",\"pid\":-1,"
+				"\"tid\":0,\"ts\":%lu}",
+				nombre(nombre_vector, NUM_NOMBRES(nombre_vector), ev.arg), ts);
+			break;
+		}
+	}
+	printf("\n]\n");
+	free(vistos);
+	return 0;
+}
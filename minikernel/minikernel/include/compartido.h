@@ -0,0 +1,217 @@
+/*
+ *  minikernel/include/compartido.h
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ *
+ * Fichero de cabecera que contiene las estructuras de datos que el kernel
+ * comparte con la biblioteca de usuario. Lo incluyen tanto kernel.h como
+ * usuario/lib/serv.c.
+ *
+ */
+
+#ifndef _COMPARTIDO_H
+#define _COMPARTIDO_H
+
+#include "const.h"
+
+/*
+ * Un identificador de proceso lleva en los bits bajos la entrada de la
+ * tabla de procesos que ocupa y en los altos la generacion de esa entrada,
+ * de modo que al reutilizarla el nuevo proceso tiene otro identificador.
+ */
+#define BITS_RANURA 16
+#define MAX_RANURAS (1 << BITS_RANURA)			/* limite de la tabla de procesos */
+#define MASCARA_RANURA (MAX_RANURAS - 1)
+
+/*
+ * Palabra de cerrojo de un mutex, legible y modificable desde modo
+ * usuario con operaciones atomicas. En palabra se guarda 0 si esta libre
+ * o el id+1 de su poseedor; el bit CERROJO_ESPERAS indica que hay
+ * procesos bloqueados en el kernel y que liberarlo requiere una llamada.
+ */
+#define CERROJO_ESPERAS 0x40000000
+
+typedef struct {
+	volatile int palabra;		/* 0 | id+1 del poseedor [| CERROJO_ESPERAS] */
+	int cuenta;					/* veces que lo ha bloqueado su poseedor */
+	int tipo;					/* RECURSIVO | NO_RECURSIVO */
+} cerrojo_usuario;
+
+/*
+ * Palabra de un cerrojo de lectores/escritores. Los bits bajos cuentan los
+ * lectores que lo poseen; LE_ESCRITOR indica que lo posee un escritor y
+ * LE_ESPERAS que hay procesos bloqueados en el kernel. Sin ninguno de los
+ * dos bits un lector lo adquiere y lo libera desde modo usuario.
+ */
+#define LE_ESCRITOR 0x40000000
+#define LE_ESPERAS 0x20000000
+#define LE_LECTORES (LE_ESPERAS - 1)
+
+typedef struct {
+	volatile int palabra;		/* lectores [| LE_ESCRITOR] [| LE_ESPERAS] */
+} cerrojo_le;
+
+/*
+ * Buffer de salida por consola de cada proceso. La biblioteca acumula en
+ * el el texto de escribir y printf y lo vacia con la llamada escribirv
+ * segun el modo; el kernel vacia lo pendiente cuando el proceso termina.
+ */
+#define TAM_BUF_SALIDA 512
+
+#define SALIDA_DIRECTA 0		/* sin buffer: una llamada por escribir */
+#define SALIDA_LINEA 1			/* se vacia al escribir '\n' o llenarse */
+#define SALIDA_COMPLETA 2		/* se vacia solo al llenarse */
+
+/*
+ * Fragmento de texto de la llamada escribirv
+ */
+typedef struct {
+	char *texto;
+	unsigned int longi;
+} fragmento;
+
+/*
+ * Datos de un proceso que se le exponen en modo usuario
+ */
+typedef struct {
+	int id;										/* ident. del proceso */
+	cerrojo_usuario *cerrojos[NUM_MUT_PROC];	/* cerrojo de cada descriptor de mutex */
+	cerrojo_le *cerrojos_le[NUM_LE_PROC];		/* cerrojo de cada descriptor de lectores/escritores */
+	int lecturas_le[NUM_LE_PROC];				/* lecturas que posee de cada uno */
+	int modo_salida;							/* SALIDA_... */
+	unsigned int num_salida;					/* bytes pendientes en salida */
+	char salida[TAM_BUF_SALIDA];				/* buffer de salida por consola */
+} datos_proceso;
+
+/*
+ * Pagina de datos del kernel visible desde todos los procesos. El kernel
+ * actualiza actual en cada cambio de proceso, por lo que un proceso que
+ * la lee siempre obtiene sus propios datos. Los contadores permiten a la
+ * biblioteca consultar el reloj y la actividad del planificador sin
+ * entrar en el kernel; los procesos solo deben leerla.
+ */
+typedef struct {
+	datos_proceso * volatile actual;	/* datos del proceso en ejecucion */
+	volatile unsigned long ticks;		/* ticks de reloj desde el arranque */
+	volatile unsigned long ns_reloj;	/* ns dedicados a tratar esos ticks */
+	volatile unsigned long cambios_proceso;	/* elecciones del planificador */
+	volatile unsigned long expulsiones;	/* procesos expulsados por rodaja */
+	volatile unsigned long llamadas;	/* llamadas al sistema atendidas */
+} pagina_kernel;
+
+/*
+ * Estadisticas de uso de UCP de un proceso que devuelve la llamada
+ * obtener_estadisticas
+ */
+typedef struct {
+	int id;									/* ident. del proceso */
+	int estado;								/* LISTO|EJECUCION|BLOQUEADO|ZOMBI */
+	unsigned long ticks_modo_usuario;		/* ticks ejecutando en modo usuario */
+	unsigned long ticks_modo_sistema;		/* ticks ejecutando dentro del kernel */
+	unsigned long cambios_voluntarios;		/* veces que ha dejado la UCP al bloquearse */
+	unsigned long cambios_involuntarios;	/* veces que ha sido expulsado */
+	unsigned long ticks_espera_listo;		/* ticks esperando en la cola de listos */
+} estadisticas_proceso;
+
+/*
+ * Registro binario de la traza de eventos del kernel. La llamada leer_traza
+ * los copia en orden de secuencia; el tiempo es el tick de reloj.
+ */
+#define TAM_TRAZA 4096			/* eventos del buffer circular (potencia de 2) */
+
+#define EV_CAMBIO 0				/* cambio de proceso: id -> arg */
+#define EV_BLOQUEO 1			/* id se bloquea; arg = tipo de bloqueo */
+#define EV_DESPERTAR 2			/* id se desbloquea; arg = tipo de bloqueo */
+#define EV_LLAMADA 3			/* id entra en la llamada arg */
+#define EV_FIN_LLAMADA 4		/* id sale de la llamada arg con resultado valor */
+#define EV_INTERRUPCION 5		/* interrupcion o excepcion del vector arg */
+
+/* Tipos de bloqueo de un proceso (arg de EV_BLOQUEO y EV_DESPERTAR) */
+#define BLOQUEO_DORMIR 0
+#define BLOQUEO_MUTEX 1
+#define BLOQUEO_RR 2
+#define BLOQUEO_TERMINAL 3
+#define BLOQUEO_MUTEX_LIBRE 4
+#define BLOQUEO_HIJO 5
+#define BLOQUEO_SEMAFORO 6
+#define BLOQUEO_CONDICION 7
+#define BLOQUEO_LECTURA 8
+#define BLOQUEO_ESCRITURA 9
+#define BLOQUEO_BARRERA 10
+
+typedef struct {
+	unsigned long secuencia;	/* numero de evento desde el arranque (desde 1) */
+	unsigned long tick;			/* ticks_sistema al registrarlo */
+	int tipo;					/* EV_... */
+	int id;						/* proceso afectado (-1 si ninguno) */
+	int arg;
+	long valor;
+} evento_traza;
+
+/*
+ * Modos de la llamada leer: devolver en cuanto haya algun caracter o
+ * esperar a que haya una linea completa (terminada en '\n').
+ */
+#define LEER_CARACTERES 0
+#define LEER_LINEA 1
+
+/*
+ * Valor que devuelve esperar_barrera al ultimo proceso en llegar, para
+ * que uno solo del grupo haga el trabajo serie entre fases. Los demas
+ * reciben 0.
+ */
+#define BARRERA_SERIE 1
+
+/*
+ * Anillo de llamadas agrupadas. El proceso encola peticiones (numero de
+ * llamada y argumentos, como los registros de llamsis) avanzando
+ * sub_cola, y la llamada procesar_anillo las ejecuta todas en una sola
+ * entrada al kernel, dejando cada resultado en la cola de finalizaciones
+ * con el dato de la peticion. Los indices crecen sin limite y se toman
+ * modulo TAM_ANILLO.
+ */
+#define TAM_ANILLO 64			/* peticiones del anillo (potencia de 2) */
+#define ARGS_PETICION 3			/* argumentos maximos de una peticion */
+
+typedef struct {
+	int llamada;				/* numero de llamada (llamsis.h) */
+	long args[ARGS_PETICION];	/* argumentos en los registros 1, 2, ... */
+	long dato;					/* valor del usuario devuelto con el resultado */
+} peticion;
+
+typedef struct {
+	int llamada;
+	int resultado;
+	long dato;
+} finalizacion;
+
+typedef struct {
+	volatile unsigned int sub_cabeza;	/* siguiente peticion que ejecuta el kernel */
+	volatile unsigned int sub_cola;		/* siguiente peticion libre del usuario */
+	volatile unsigned int fin_cabeza;	/* siguiente resultado que recoge el usuario */
+	volatile unsigned int fin_cola;		/* siguiente resultado libre del kernel */
+	peticion peticiones[TAM_ANILLO];
+	finalizacion finalizaciones[TAM_ANILLO];
+} anillo_llamadas;
+
+/*
+ * Contadores de una llamada al sistema que devuelve volcar_llamadas. La
+ * latencia va desde la entrada en el servicio hasta su vuelta, incluido
+ * el tiempo bloqueado, y se mide con el reloj de la maquina anfitriona;
+ * la cubeta i del histograma cuenta las de [2^i, 2^(i+1)) nanosegundos.
+ */
+#define CUBETAS_LATENCIA 32
+
+typedef struct {
+	unsigned long llamadas;					/* veces que se ha llamado */
+	unsigned long errores;					/* veces que ha devuelto < 0 */
+	unsigned long ticks;					/* ticks de reloj transcurridos */
+	unsigned long ns;						/* nanosegundos transcurridos */
+	unsigned long cubetas[CUBETAS_LATENCIA];	/* histograma log2 en ns */
+} estadisticas_llamada;
+
+#endif /* _COMPARTIDO_H */
@@ -22,7 +22,7 @@
 #define NULL (void *) 0		/* por si acaso no esta ya definida */
 #endif
 
-#define MAX_PROC 10		/* dimension de tabla de procesos */
+#define MAX_PROC 10		/* dimension inicial de tabla de procesos */
 
 #define TAM_PILA 32768
 
@@ -35,6 +35,7 @@
 #define LISTO 1
 #define EJECUCION 2
 #define BLOQUEADO 3
+#define ZOMBI 4		/* Proc. terminado que su padre no ha esperado */
 
 /*
  * Niveles de ejecuci�n del procesador. 
@@ -73,8 +74,35 @@
 			  abiertos un proceso */
 #define MAX_NOM_MUT 8 /* longitud maxima de un nombre de mutex */
 
+/* constantes usadas en implementacion de semaforos */
+#define NUM_SEM 16 /* numero total de semaforos en el sistema */
+#define NUM_SEM_PROC 4 /* numero maximo de semaforos que puede tener
+			  abiertos un proceso */
+#define MAX_NOM_SEM 8 /* longitud maxima de un nombre de semaforo */
+
+/* constantes usadas en implementacion de variables condicion */
+#define NUM_COND 16 /* numero total de variables condicion en el sistema */
+#define NUM_COND_PROC 4 /* numero maximo de variables condicion que puede
+			  tener abiertas un proceso */
+#define MAX_NOM_COND 8 /* longitud maxima de un nombre de variable condicion */
+
+/* constantes usadas en implementacion de cerrojos de lectores/escritores */
+#define NUM_LE 16 /* numero total de cerrojos de lectores/escritores */
+#define NUM_LE_PROC 4 /* numero maximo de cerrojos de lectores/escritores
+			  que puede tener abiertos un proceso */
+#define MAX_NOM_LE 8 /* longitud maxima de un nombre de cerrojo */
+
+/* constantes usadas en implementacion de barreras */
+#define NUM_BAR 16 /* numero total de barreras en el sistema */
+#define NUM_BAR_PROC 4 /* numero maximo de barreras que puede tener
+			  abiertas un proceso */
+#define MAX_NOM_BAR 8 /* longitud maxima de un nombre de barrera */
+
+#define IMAGENES_EN_CACHE 8 /* imagenes sin usar que conserva el kernel */
+#define MAX_NOM_PROG 100 /* longitud maxima del nombre de un programa */
+
 /* constante usada en implementacion de manejador de terminal */
-#define TAM_BUF_TERM 8 /* tama�o del buffer del terminal */
+#define TAM_BUF_TERM 256 /* tamano por defecto del buffer del terminal */
 
 /* direcci�n de puerto de E/S del terminal */
 #define DIR_TERMINAL 1
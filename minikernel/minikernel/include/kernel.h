@@ -21,19 +21,124 @@
 /* Definicion del tipo de Mutex */
 #define NO_RECURSIVO 0
 #define RECURSIVO 1
+/* Definicion de la preferencia de un cerrojo de lectores/escritores */
+#define PREFERENCIA_LECTORES 0
+#define PREFERENCIA_ESCRITORES 1
 /* Definicion del estado del Mutex */
 #define LIBRE 0
 #define OCUPADO 1
-/* Definicion de tipos de bloqueo de un  proceso */
-#define BLOQUEO_DORMIR 0
-#define BLOQUEO_MUTEX 1
-#define BLOQUEO_RR 2
-#define BLOQUEO_TERMINAL 3
+
+#define SALIDA_EXCEPCION -1	/* estado de salida de un proceso abortado */
+
+/* Numero de ranuras de la rueda de temporizacion de dormir (potencia de 2) */
+#define TAM_RUEDA 256
+
+/*
+ * Politicas de planificacion. Se elige una al compilar el kernel, p.ej.
+ * "make PLANIFICACION=PLANIF_MLFQ". Por defecto FIFO sin expulsion.
+ * PLANIF_PRIO usa prioridades fijas, que cada proceso elige con
+ * fijar_prioridad, con expulsion y round robin dentro de cada nivel; el
+ * poseedor de un mutex hereda la prioridad de los que lo esperan.
+ */
+#define PLANIF_FIFO 0
+#define PLANIF_RR 1
+#define PLANIF_MLFQ 2
+#define PLANIF_CFS 3
+#define PLANIF_PRIO 4
+#ifndef PLANIFICACION
+#define PLANIFICACION PLANIF_FIFO
+#endif
+
+/* Politicas cuyos listos son una cola por nivel de prioridad */
+#define COLAS_PRIORIDAD (PLANIFICACION == PLANIF_MLFQ || PLANIFICACION == PLANIF_PRIO)
+
+/*
+ * Politicas de reparto de la entrada del terminal entre varios lectores
+ * bloqueados. Se elige una al compilar, p.ej.
+ * "make POLITICA_TERMINAL=TERMINAL_DIFUSION":
+ *	TERMINAL_ENTREGA: el manejador de interrupcion completa la peticion
+ *		del primer lector en espera en cuanto hay datos para ella y le
+ *		despierta ya servido, en orden FIFO. Por defecto.
+ *	TERMINAL_DIFUSION: cada caracter despierta al primer lector y cada fin
+ *		de linea (o buffer lleno) a todos; al ejecutar compiten por los
+ *		datos y los que no obtienen nada vuelven a bloquearse.
+ */
+#define TERMINAL_ENTREGA 0
+#define TERMINAL_DIFUSION 1
+#ifndef POLITICA_TERMINAL
+#define POLITICA_TERMINAL TERMINAL_ENTREGA
+#endif
+
+/* Constantes usadas en la planificacion por colas multinivel (MLFQ y PRIO) */
+#define NUM_PRIORIDADES 4	/* niveles de prioridad, 0 es el mas prioritario */
+#define TICKS_RODAJA(prio) (TICKS_POR_RODAJA << (prio))	/* rodaja de cada nivel */
+#define TICKS_IMPULSO TICK	/* periodo con el que todos vuelven al nivel 0 */
+
+/* Constantes usadas en la planificacion equitativa (CFS) */
+#define LATENCIA_OBJETIVO 20	/* ticks en los que deben ejecutar todos los listos */
+#define GRANULARIDAD_MIN 2		/* rodaja minima en ticks */
 
 #include "const.h"
 #include "HAL.h"
 #include "llamsis.h"
+#include "compartido.h"
 #include "string.h"
+#include "stdlib.h"
+#include "time.h"
+#include "limits.h"
+
+/*
+ * Niveles de traza del kernel. Se fija uno al compilar, p.ej.
+ * "make NIVEL_TRAZA=TRAZA_NADA"; los mensajes de nivel superior no
+ * generan codigo, de modo que no cuestan nada en el reloj, int_sw, el
+ * tratamiento de llamadas ni los mutex.
+ */
+#define TRAZA_NADA 0		/* ningun mensaje */
+#define TRAZA_ERRORES 1		/* errores y excepciones */
+#define TRAZA_EVENTOS 2		/* creacion y fin de procesos, bloqueos raros */
+#define TRAZA_DETALLE 3		/* cada interrupcion, cola de listos, etc. */
+#ifndef NIVEL_TRAZA
+#define NIVEL_TRAZA TRAZA_EVENTOS
+#endif
+
+#if NIVEL_TRAZA >= TRAZA_ERRORES
+#define PRINTK_ERROR(...) printk(__VA_ARGS__)
+#else
+#define PRINTK_ERROR(...) ((void)0)
+#endif
+#if NIVEL_TRAZA >= TRAZA_EVENTOS
+#define PRINTK_EVENTO(...) printk(__VA_ARGS__)
+#else
+#define PRINTK_EVENTO(...) ((void)0)
+#endif
+#if NIVEL_TRAZA >= TRAZA_DETALLE
+#define PRINTK_DETALLE(...) printk(__VA_ARGS__)
+#else
+#define PRINTK_DETALLE(...) ((void)0)
+#endif
+
+typedef struct BCP_t *BCPptr;
+typedef struct mutex_t * mutex_ptr;
+typedef struct semaforo_t * semaforo_ptr;
+typedef struct condicion_t * condicion_ptr;
+typedef struct lectores_escritores_t * le_ptr;
+typedef struct barrera_t * barrera_ptr;
+typedef struct imagen_t * imagen_ptr;
+
+/*
+ *
+ * Definicion del tipo que corresponde con la cabecera de una lista
+ * de BCPs. Este tipo se puede usar para diversas listas (procesos listos,
+ * procesos bloqueados en sem�foro, etc.).
+ *
+ */
+
+typedef struct{
+	
+	BCPptr primero;
+	BCPptr ultimo;
+
+} lista_BCPs;
 
 /*
  *
@@ -41,59 +146,160 @@
  * Se va a modificar al incluir la funcionalidad pedida.
  *
  */
-typedef struct BCP_t *BCPptr;
-typedef struct mutex_t * mutex_ptr;
-
 typedef struct BCP_t {
     
 	BCPptr siguiente;			/* puntero a otro BCP */
 	int id;						/* ident. del proceso */
-    int estado;					/* TERMINADO|LISTO|EJECUCION|BLOQUEADO*/
+    int estado;					/* TERMINADO|LISTO|EJECUCION|BLOQUEADO|ZOMBI*/
     contexto_t contexto_regs;	/* copia de regs. de UCP */
     void * pila;				/* dir. inicial de la pila */
 	void *info_mem;				/* descriptor del mapa de memoria */
-	long despertar_en; 			/* tiempo en "segundos" que el BCP tiene que desbloquearse "por tiempo". */
+	imagen_ptr imagen;			/* entrada de la cache de imagenes que usa */
+	unsigned long despertar_en;	/* tick absoluto en el que el BCP tiene que desbloquearse "por tiempo". */
 	mutex_ptr descriptores_mutex[NUM_MUT_PROC];
-	int tick_round_robin;
+	mutex_ptr mutex_espera;		/* mutex en cuya cola esta bloqueado */
+	semaforo_ptr descriptores_sem[NUM_SEM_PROC];
+	semaforo_ptr sem_espera;	/* semaforo en cuya cola esta bloqueado */
+	condicion_ptr descriptores_cond[NUM_COND_PROC];
+	condicion_ptr cond_espera;	/* variable condicion en cuya cola esta bloqueado */
+	mutex_ptr mutex_cond;		/* mutex que debe recuperar al dejar de esperarla */
+	le_ptr descriptores_le[NUM_LE_PROC];
+	le_ptr le_espera;			/* cerrojo de lectores/escritores en cuya cola esta bloqueado */
+	barrera_ptr descriptores_bar[NUM_BAR_PROC];
+	barrera_ptr barrera_espera;	/* barrera en cuya cola esta bloqueado */
+	datos_proceso datos_usuario;	/* datos expuestos en la pagina del kernel */
+	int tick_round_robin;		/* ticks que le quedan de rodaja */
+	int prioridad;				/* nivel de MLFQ o PRIO (0 en el resto de politicas) */
+	int prioridad_base;			/* nivel fijado con fijar_prioridad, sin herencia (PRIO) */
+	unsigned long vruntime;		/* ticks de UCP consumidos (CFS) */
+	int pos_monticulo;			/* posicion en el monticulo de listos (CFS) */
+	estadisticas_proceso estadisticas;	/* contabilidad de uso de UCP */
+	unsigned long listo_desde;	/* tick en el que entro en la cola de listos */
+	unsigned int generacion;	/* veces que se ha reutilizado su entrada */
+	BCPptr padre;				/* proceso que lo creo (NULL si ya no existe) */
+	BCPptr hijos;				/* hijos vivos */
+	BCPptr hijos_zombis;		/* hijos terminados que no ha esperado */
+	BCPptr hermano_anterior;	/* vecinos en la lista de hijos de su padre */
+	BCPptr hermano_siguiente;
+	int estado_salida;			/* valor con el que termino (si es ZOMBI) */
+	int hijo_esperado;			/* id del hijo que espera (-1 cualquiera) */
+	lista_BCPs esperando_hijo;	/* cola de espera por la terminacion de un hijo */
+	char *destino_terminal;		/* peticion de lectura pendiente del terminal */
+	int max_terminal;
+	int modo_terminal;
+	int leidos_terminal;		/* resultado de la lectura entregada */
 } BCP;
 
+/*
+ * Composicion del identificador de proceso (ver compartido.h). El id+1 se
+ * guarda en la palabra del cerrojo de los mutex, por lo que no puede
+ * llegar a CERROJO_ESPERAS.
+ */
+#define MASCARA_GENERACION ((1 << 13) - 1)
+#define ID_PROCESO(ranura, gen) ((int)(((gen) << BITS_RANURA) | (ranura)))
+
+#define TAM_LINEA_CACHE 64		/* alineamiento de las pilas de proceso */
+
+
+
 typedef struct mutex_t {
-	char * nombre;					/* nombre del mutex */
-	int tipo;						/* RECURSIVO | NO RECURSIVO */
+	cerrojo_usuario cerrojo;		/* poseedor, cuenta y tipo, compartidos con modo usuario */
+	char nombre[MAX_NOM_MUT+1];		/* nombre del mutex */
 	int estado;						/* LIBRE | OCUPADO */
-	int num_bloqueos;				/* numero de veces que se ha bloqueado llamando a lock(); */
-	int id_proc_poseedor;
-	
-	// BUFFER DE PIDS 
-	int procesos_bloqueados[MAX_PROC]; 	/* array de PID de procesos bloqueados por el mutex. */
-	int in_insertar;
-	int in_borrar;
+	lista_BCPs procesos_bloqueados;	/* cola FIFO de procesos bloqueados en lock() */
 	int num_procesos_bloqueados;	/* numero de procesos que se han bloqueado con lock() y no poseian el mutex. */
+	int num_abiertos;				/* numero de descriptores que lo referencian */
+	mutex_ptr siguiente;			/* siguiente en su cubeta del hash o en la lista de libres */
 
 } mutex;
 
+/*
+ * Definicion del tipo que corresponde con un semaforo contador con nombre
+ */
+typedef struct semaforo_t {
+	char nombre[MAX_NOM_SEM+1];		/* nombre del semaforo */
+	int estado;						/* LIBRE | OCUPADO */
+	int valor;						/* unidades disponibles */
+	lista_BCPs procesos_bloqueados;	/* cola FIFO de procesos bloqueados en esperar_sem */
+	int num_abiertos;				/* numero de descriptores que lo referencian */
+	semaforo_ptr siguiente;			/* siguiente en su cubeta del hash o en la lista de libres */
+} semaforo;
 
 /*
- *
- * Definicion del tipo que corresponde con la cabecera de una lista
- * de BCPs. Este tipo se puede usar para diversas listas (procesos listos,
- * procesos bloqueados en sem�foro, etc.).
- *
+ * Definicion del tipo que corresponde con una variable condicion con
+ * nombre. Cada proceso que la espera indica el mutex que tiene asociado.
  */
+typedef struct condicion_t {
+	char nombre[MAX_NOM_COND+1];	/* nombre de la variable condicion */
+	int estado;						/* LIBRE | OCUPADO */
+	lista_BCPs procesos_bloqueados;	/* cola FIFO de procesos en esperar_cond */
+	int num_abiertos;				/* numero de descriptores que la referencian */
+	condicion_ptr siguiente;		/* siguiente en su cubeta del hash o en la lista de libres */
+} condicion;
 
-typedef struct{
-	
-	BCP *primero;
-	BCP *ultimo;
+/*
+ * Definicion del tipo que corresponde con un cerrojo de lectores/escritores
+ * con nombre. Lectores y escritores esperan en colas separadas.
+ */
+typedef struct lectores_escritores_t {
+	cerrojo_le cerrojo;				/* lectores y bits, compartidos con modo usuario */
+	char nombre[MAX_NOM_LE+1];		/* nombre del cerrojo */
+	int estado;						/* LIBRE | OCUPADO */
+	int preferencia;				/* PREFERENCIA_LECTORES | PREFERENCIA_ESCRITORES */
+	int escritor;					/* id del escritor que lo posee (-1 si ninguno) */
+	lista_BCPs lectores_bloqueados;	/* cola FIFO de procesos en lock_lectura */
+	lista_BCPs escritores_bloqueados;	/* cola FIFO de procesos en lock_escritura */
+	int num_abiertos;				/* numero de descriptores que lo referencian */
+	le_ptr siguiente;				/* siguiente en su cubeta del hash o en la lista de libres */
+} lectores_escritores;
 
-} lista_BCPs;
+/*
+ * Definicion del tipo que corresponde con una barrera con nombre para
+ * grupos de num_procesos procesos
+ */
+typedef struct barrera_t {
+	char nombre[MAX_NOM_BAR+1];		/* nombre de la barrera */
+	int estado;						/* LIBRE | OCUPADO */
+	int num_procesos;				/* procesos que forman el grupo */
+	int llegados;					/* procesos del grupo que ya la esperan */
+	lista_BCPs procesos_bloqueados;	/* procesos que esperan al resto del grupo */
+	int num_abiertos;				/* numero de descriptores que la referencian */
+	barrera_ptr siguiente;			/* siguiente en su cubeta del hash o en la lista de libres */
+} barrera;
+
+/*
+ * Definicion del tipo que corresponde con una imagen de programa cargada.
+ * Las de los procesos existentes estan referenciadas; las que no, quedan
+ * en una lista LRU hasta que se reutilizan o se descartan.
+ */
+typedef struct imagen_t {
+	char nombre[MAX_NOM_PROG+1];	/* programa del que se ha creado */
+	void *mem;						/* descriptor devuelto por crear_imagen */
+	void *pc_inicial;				/* punto de arranque del programa */
+	int referencias;				/* procesos que la usan */
+	imagen_ptr siguiente_hash;		/* siguiente en su cubeta del hash */
+	imagen_ptr anterior_lru;		/* vecinos en la lista LRU (sin referencias) */
+	imagen_ptr siguiente_lru;
+} imagen;
+
+/* Identificador del poseedor de un mutex (-1 si esta libre) */
+#define POSEEDOR_MUTEX(m) ((((m)->cerrojo.palabra) & ~CERROJO_ESPERAS) - 1)
 
+/*
+ * Buffer circular de entrada del terminal. Su tamano es una potencia de 2
+ * que se fija en el arranque (TAM_BUF_TERM, salvo que la variable de
+ * entorno del mismo nombre indique otro), por lo que los indices avanzan
+ * con una mascara.
+ */
 typedef struct 
 {
-	char buffer_terminal[TAM_BUF_TERM];
-	int in_borrar;
-	int in_insertar;
-	int num_elementos;
+	char *buffer_terminal;
+	unsigned int mascara;		/* tamano - 1 */
+	unsigned int in_borrar;
+	unsigned int in_insertar;
+	unsigned int num_elementos;
+	unsigned int num_lineas;	/* caracteres '\n' en el buffer */
+	unsigned long perdidos;		/* caracteres descartados con el buffer lleno */
 	
 }buffer;
 
@@ -105,16 +311,112 @@ BCP * p_proc_actual=NULL;
 
 
 /*
- * Variable global que representa la tabla de procesos
+ * Variable global que representa la pagina de datos del kernel que se
+ * comparte con los procesos
  */
+pagina_kernel pagina;
 
-BCP tabla_procs[MAX_PROC];
+/*
+ * Variable global que representa la tabla de procesos. Es un vector de
+ * punteros, indexado por la entrada del id, que crece por duplicacion; los
+ * BCP se reservan por bloques y no se mueven, ya que las listas los
+ * enlazan por direccion. Las entradas libres forman una cola FIFO, de
+ * modo que una entrada recien liberada es la ultima en reutilizarse.
+ */
+
+BCP **tabla_procs=NULL;
+int tam_tabla_procs=0;
+lista_BCPs bcps_libres={NULL, NULL};
 
 /*
- * Variable global que representa la tabla de mutex
+ * Variables globales que representan la reserva de pilas de proceso. Las
+ * pilas libres se encadenan por su primera palabra. Se recuerda el maximo
+ * de pilas en uso simultaneo (desde el arranque y en la ventana actual de
+ * un segundo) para decidir cuantas libres conservar.
  */
+void *pilas_libres=NULL;
+int num_pilas_libres=0;
+int min_pilas_libres=MAX_PROC;
+int pilas_en_uso=0;
+int max_pilas_en_uso=0;
+int max_pilas_ventana=0;
+unsigned long inicio_ventana_pilas=0;
 
-mutex tabla_mutex[NUM_MUT];
+/*
+ * Variable global que representa la tabla de mutex. Se reserva en el
+ * arranque con num_mut entradas (NUM_MUT, salvo que la variable de
+ * entorno NUM_MUT indique otro tamano).
+ */
+
+mutex *tabla_mutex=NULL;
+int num_mut=NUM_MUT;
+
+/*
+ * Indice de los mutex en uso por nombre (cubetas encadenadas por el campo
+ * siguiente) y lista de entradas libres de tabla_mutex.
+ */
+mutex_ptr *hash_mutex=NULL;
+unsigned int tam_hash_mutex=0;
+mutex_ptr mutex_libres=NULL;
+
+/*
+ * Variables globales que representan la tabla de semaforos, de num_sem
+ * entradas (NUM_SEM, salvo que la variable de entorno NUM_SEM indique
+ * otro tamano), su indice por nombre y su lista de entradas libres.
+ */
+semaforo *tabla_sem=NULL;
+int num_sem=NUM_SEM;
+semaforo_ptr *hash_sem=NULL;
+unsigned int tam_hash_sem=0;
+semaforo_ptr sem_libres=NULL;
+
+/*
+ * Variables globales que representan la tabla de variables condicion, de
+ * num_cond entradas (NUM_COND, salvo que la variable de entorno NUM_COND
+ * indique otro tamano), su indice por nombre y su lista de libres.
+ */
+condicion *tabla_cond=NULL;
+int num_cond=NUM_COND;
+condicion_ptr *hash_cond=NULL;
+unsigned int tam_hash_cond=0;
+condicion_ptr cond_libres=NULL;
+
+/*
+ * Variables globales que representan la tabla de cerrojos de
+ * lectores/escritores, de num_le entradas (NUM_LE, salvo que la variable
+ * de entorno NUM_LE indique otro tamano), su indice y su lista de libres.
+ */
+lectores_escritores *tabla_le=NULL;
+int num_le=NUM_LE;
+le_ptr *hash_le=NULL;
+unsigned int tam_hash_le=0;
+le_ptr le_libres=NULL;
+
+/*
+ * Variables globales que representan la tabla de barreras, de num_bar
+ * entradas (NUM_BAR, salvo que la variable de entorno NUM_BAR indique
+ * otro tamano), su indice por nombre y su lista de entradas libres.
+ */
+barrera *tabla_bar=NULL;
+int num_bar=NUM_BAR;
+barrera_ptr *hash_bar=NULL;
+unsigned int tam_hash_bar=0;
+barrera_ptr bar_libres=NULL;
+
+/*
+ * Variables globales que representan la cache de imagenes: indice por
+ * nombre de programa, lista LRU de las que no usa ningun proceso (de la
+ * menos a la mas recientemente usada) y cuantas de estas se conservan.
+ * referencias_imagenes suma las de todas, es decir, los procesos vivos.
+ */
+#define TAM_HASH_IMAGENES 64	/* cubetas del indice (potencia de 2) */
+
+imagen_ptr hash_imagenes[TAM_HASH_IMAGENES];
+imagen_ptr imagenes_lru_primera=NULL;
+imagen_ptr imagenes_lru_ultima=NULL;
+int num_imagenes_lru=0;
+int max_imagenes_lru=IMAGENES_EN_CACHE;
+int referencias_imagenes=0;
 
 /*
  * Variable global que representa el buffer del terminal
@@ -126,18 +428,66 @@ buffer buffer_terminal;
  */
 lista_BCPs lista_listos= {NULL, NULL};
 
+#if COLAS_PRIORIDAD
+/*
+ * Variables globales que representan las colas de listos de cada nivel
+ * de prioridad y el mapa de bits de las que no estan vacias.
+ */
+lista_BCPs colas_listos[NUM_PRIORIDADES];
+unsigned int mapa_listos=0;
+#endif
+
+#if PLANIFICACION == PLANIF_CFS
+/*
+ * Variables globales que representan el monticulo de listos ordenado por
+ * vruntime y el menor vruntime visto, usado para situar a los que llegan.
+ */
+BCP ** monticulo_listos=NULL;		/* tam_tabla_procs entradas */
+int num_listos=0;
+unsigned long vruntime_min=0;
+#endif
+
+/*
+ * Variable global que identifica el proceso al que se ha pedido expulsar
+ * con la interrupcion software
+ */
+BCP * proc_a_expulsar=NULL;
+
 /*
  * Variable global que representa la cola de procesos bloqueados
  */
 lista_BCPs lista_bloqueados={NULL, NULL};
 
 /*
- * Variable global que representa la cola de procesos bloqueados
+ * Variable global que cuenta los ticks de reloj desde el arranque
+ */
+unsigned long ticks_sistema=0;
+
+/*
+ * Variables globales que representan el buffer circular de la traza de
+ * eventos: traza_escritos cuenta los registrados desde el arranque y
+ * traza_leidos los ya entregados con leer_traza.
+ */
+evento_traza traza[TAM_TRAZA];
+unsigned long traza_escritos=0;
+unsigned long traza_leidos=0;
+
+/*
+ * Variable global con los contadores y el histograma de latencia de cada
+ * llamada al sistema, indexada por su numero
+ */
+estadisticas_llamada estadisticas_llamadas[NSERVICIOS];
+
+/*
+ * Variable global que representa la rueda de temporizacion de los procesos
+ * dormidos: cada ranura guarda los BCPs cuyo despertar_en cae en ella
+ * (despertar_en & (TAM_RUEDA-1)), de modo que cada tick solo recorre una.
  */
-lista_BCPs lista_bloqueados_dormir={NULL, NULL};
+lista_BCPs rueda_dormir[TAM_RUEDA];
 
 /*
- * Variable global que representa la cola de procesos bloqueados por mutex.
+ * Variable global que representa la cola de procesos bloqueados a la
+ * espera de que quede libre una entrada de la tabla de mutex.
  */
 lista_BCPs lista_bloqueados_mutex_libre={NULL, NULL};
 
@@ -171,21 +521,64 @@ int sis_cerrar_mutex();
 int sis_lock_mutex();
 int sis_unlock_mutex();
 int sis_leer_caracter();
+int sis_obtener_ticks();
+int sis_obtener_pagina();
+int sis_obtener_estadisticas();
+int sis_leer_traza();
+int sis_listar_procesos();
+int sis_crear_procesos();
+int sis_leer();
+int sis_escribirv();
+int sis_procesar_anillo();
+int sis_volcar_llamadas();
+int sis_fijar_prioridad();
+int sis_crear_sem();
+int sis_abrir_sem();
+int sis_esperar_sem();
+int sis_senalar_sem();
+int sis_cerrar_sem();
+int sis_crear_cond();
+int sis_abrir_cond();
+int sis_esperar_cond();
+int sis_senalar_cond();
+int sis_difundir_cond();
+int sis_cerrar_cond();
+int sis_crear_le();
+int sis_abrir_le();
+int sis_lock_lectura();
+int sis_lock_escritura();
+int sis_unlock_le();
+int sis_cerrar_le();
+int sis_crear_barrera();
+int sis_abrir_barrera();
+int sis_esperar_barrera();
+int sis_cerrar_barrera();
+int sis_esperar_proceso();
+int sis_esperar_cualquiera();
 
 void bloquear_proceso(BCP * proceso, int tipo);
 void desbloquear_proceso(BCP * proceso, int tipo);
+void desbloquear_grupo(lista_BCPs *grupo, int tipo);
 void inter_sw_fin_rodaja_RR();
 void comprobar_fin_rodaja_RR();
-void actualizar_tiempos();
+void avanzar_rueda();
+void registrar_evento(int tipo, int id, int arg, long valor);
 void insertar_buffer(char car);
 int es_buffer_vacio();
 int es_buffer_lleno();
 char borrar_buffer();
+int copiar_buffer(char *destino, int max, int modo);
 void imprimir_lista(lista_BCPs lista);
+void imprimir_listos();
 void liberar_mutex(int descriptor);
+void ceder_mutex(mutex_ptr m);
 int aux_unlock_mutex(int descriptor);
+void liberar_sem(int descriptor);
+void liberar_cond(int descriptor);
+void liberar_le(int descriptor);
+void liberar_barrera(int descriptor);
 
-// void asignar_mutex(char* nombre, int tipo, int in_desc, int in_t_mutex); // esta es para el tocho que hay en crear_mutex, no funciona :( .
+int leer_parametro_arranque(char *nombre, int defecto);
 
 /*
  * Variable global que contiene las rutinas que realizan cada llamada
@@ -200,7 +593,41 @@ servicio tabla_servicios[NSERVICIOS]={	{sis_crear_proceso},
 										{sis_cerrar_mutex},
 										{sis_lock_mutex},
 										{sis_unlock_mutex},
-										{sis_leer_caracter}
+										{sis_leer_caracter},
+										{sis_obtener_ticks},
+										{sis_obtener_pagina},
+										{sis_obtener_estadisticas},
+										{sis_leer_traza},
+										{sis_listar_procesos},
+										{sis_crear_procesos},
+										{sis_esperar_proceso},
+										{sis_esperar_cualquiera},
+										{sis_leer},
+										{sis_escribirv},
+										{sis_procesar_anillo},
+										{sis_volcar_llamadas},
+										{sis_fijar_prioridad},
+										{sis_crear_sem},
+										{sis_abrir_sem},
+										{sis_esperar_sem},
+										{sis_senalar_sem},
+										{sis_cerrar_sem},
+										{sis_crear_cond},
+										{sis_abrir_cond},
+										{sis_esperar_cond},
+										{sis_senalar_cond},
+										{sis_difundir_cond},
+										{sis_cerrar_cond},
+										{sis_crear_le},
+										{sis_abrir_le},
+										{sis_lock_lectura},
+										{sis_lock_escritura},
+										{sis_unlock_le},
+										{sis_cerrar_le},
+										{sis_crear_barrera},
+										{sis_abrir_barrera},
+										{sis_esperar_barrera},
+										{sis_cerrar_barrera}
 										};
 
 #endif /* _KERNEL_H */
@@ -19,7 +19,7 @@
 #define _LLAMSIS_H
 
 /* Numero de llamadas disponibles */
-#define NSERVICIOS 11
+#define NSERVICIOS 45
 
 #define CREAR_PROCESO 0
 #define TERMINAR_PROCESO 1
@@ -32,6 +32,40 @@
 #define LOCK_MUTEX 8
 #define UNLOCK_MUTEX 9
 #define LEER_CARACTER 10
+#define OBTENER_TICKS 11
+#define OBTENER_PAGINA 12
+#define OBTENER_ESTADISTICAS 13
+#define LEER_TRAZA 14
+#define LISTAR_PROCESOS 15
+#define CREAR_PROCESOS 16
+#define ESPERAR_PROCESO 17
+#define ESPERAR_CUALQUIERA 18
+#define LEER 19
+#define ESCRIBIRV 20
+#define PROCESAR_ANILLO 21
+#define VOLCAR_LLAMADAS 22
+#define FIJAR_PRIORIDAD 23
+#define CREAR_SEM 24
+#define ABRIR_SEM 25
+#define ESPERAR_SEM 26
+#define SENALAR_SEM 27
+#define CERRAR_SEM 28
+#define CREAR_COND 29
+#define ABRIR_COND 30
+#define ESPERAR_COND 31
+#define SENALAR_COND 32
+#define DIFUNDIR_COND 33
+#define CERRAR_COND 34
+#define CREAR_LE 35
+#define ABRIR_LE 36
+#define LOCK_LECTURA 37
+#define LOCK_ESCRITURA 38
+#define UNLOCK_LE 39
+#define CERRAR_LE 40
+#define CREAR_BARRERA 41
+#define ABRIR_BARRERA 42
+#define ESPERAR_BARRERA 43
+#define CERRAR_BARRERA 44
 
 #endif /* _LLAMSIS_H */
 
@@ -18,38 +18,397 @@
 /*
  *
  * Funciones relacionadas con la tabla de priocesos:
- *	iniciar_tabla_proc buscar_BCP_libre
+ *	iniciar_tabla_proc ampliar_tabla_proc buscar_BCP_libre liberar_BCP
+ *	buscar_BCP enlazar_hijo desenlazar_hijo
  *
  */
 
 /*
- * Funci�n que inicia la tabla de procesos
+ * Funcion que anade una entrada al final de la cola de libres
+ */
+static void encolar_BCP_libre(BCP * proc)
+{
+	proc->siguiente = NULL;
+	if (bcps_libres.primero == NULL)
+		bcps_libres.primero = proc;
+	else
+		bcps_libres.ultimo->siguiente = proc;
+	bcps_libres.ultimo = proc;
+}
+
+/*
+ * Funcion que amplia la tabla de procesos (a tam_inicial entradas la primera
+ * vez y al doble despues) y anade las nuevas entradas a la lista de
+ * libres. Devuelve -1 si se ha alcanzado el limite o no hay memoria.
+ */
+static int ampliar_tabla_proc(int tam_inicial)
+{
+	int nuevo_tam, i, nivel;
+	BCP *bloque, **tabla;
+#if PLANIFICACION == PLANIF_CFS
+	BCP **monticulo;
+#endif
+
+	nuevo_tam = (tam_tabla_procs == 0) ? tam_inicial : 2 * tam_tabla_procs;
+	if (nuevo_tam > MAX_RANURAS)
+		nuevo_tam = MAX_RANURAS;
+	if (nuevo_tam <= tam_tabla_procs)
+		return -1;
+
+	bloque = calloc(nuevo_tam - tam_tabla_procs, sizeof(BCP));
+	if (bloque == NULL)
+		return -1;
+
+	/* el reloj recorre la tabla y el monticulo: no deben verse a medias */
+	nivel = fijar_nivel_int(NIVEL_3);
+	tabla = realloc(tabla_procs, nuevo_tam * sizeof(BCP *));
+	if (tabla != NULL)
+		tabla_procs = tabla;	/* el vector viejo puede haberse liberado ya */
+#if PLANIFICACION == PLANIF_CFS
+	monticulo = (tabla != NULL) ? realloc(monticulo_listos, nuevo_tam * sizeof(BCP *)) : NULL;
+	if (monticulo != NULL)
+		monticulo_listos = monticulo;
+	else
+		tabla = NULL;
+#endif
+	if (tabla == NULL)
+	{
+		fijar_nivel_int(nivel);
+		free(bloque);
+		return -1;
+	}
+
+	/* las nuevas entradas quedan libres, la de menor indice la primera */
+	for (i = tam_tabla_procs; i < nuevo_tam; i++)
+	{
+		tabla_procs[i] = &bloque[i - tam_tabla_procs];
+		tabla_procs[i]->estado = NO_USADA;
+		tabla_procs[i]->id = ID_PROCESO(i, 0);
+		encolar_BCP_libre(tabla_procs[i]);
+	}
+	tam_tabla_procs = nuevo_tam;
+	fijar_nivel_int(nivel);
+	return 0;
+}
+
+/*
+ * Funcion que inicia la tabla de procesos
  */
 static void iniciar_tabla_proc()
 {
-	int i;
+	if (ampliar_tabla_proc(leer_parametro_arranque("MAX_PROC", MAX_PROC)) < 0)
+		panico("no hay memoria para la tabla de procesos");
+}
+
+/*
+ * Funcion que busca una entrada libre en la tabla de procesos,
+ * ampliandola si estan todas ocupadas. Le asigna el identificador
+ * correspondiente a su generacion.
+ */
+static BCP * buscar_BCP_libre()
+{
+	BCP *proc;
 
-	for (i=0; i<MAX_PROC; i++)
-		tabla_procs[i].estado=NO_USADA;
+	if (bcps_libres.primero == NULL && ampliar_tabla_proc(MAX_PROC) < 0)
+		return NULL;
+
+	proc = bcps_libres.primero;
+	bcps_libres.primero = proc->siguiente;
+	proc->siguiente = NULL;
+	proc->id = ID_PROCESO(proc->id & MASCARA_RANURA, proc->generacion);
+	return proc;
 }
 
 /*
- * Funci�n que busca una entrada libre en la tabla de procesos
+ * Funcion que devuelve una entrada a la cola de libres. Se cambia de
+ * generacion para que el proximo proceso que la use tenga otro id.
  */
-static int buscar_BCP_libre()
+static void liberar_BCP(BCP * proc)
 {
-	int i;
+	proc->estado = NO_USADA;
+	proc->generacion = (proc->generacion + 1) & MASCARA_GENERACION;
+	encolar_BCP_libre(proc);
+}
 
-	for (i=0; i<MAX_PROC; i++)
-		if (tabla_procs[i].estado==NO_USADA)
-			return i;
-	return -1;
+/*
+ * Funcion que devuelve el BCP del proceso con el id indicado o NULL
+ * si no existe (o su entrada ya la ocupa otro proceso).
+ */
+static BCP * buscar_BCP(int id)
+{
+	BCP *proc;
+
+	if (id < 0 || (id & MASCARA_RANURA) >= tam_tabla_procs)
+		return NULL;
+	proc = tabla_procs[id & MASCARA_RANURA];
+	if (proc->estado == NO_USADA || proc->id != id)
+		return NULL;
+	return proc;
+}
+
+/*
+ * Funcion que pone un BCP al principio de una lista de hijos (hijos o
+ * hijos_zombis de su padre)
+ */
+static void enlazar_hijo(BCPptr *lista, BCP * proc)
+{
+	proc->hermano_anterior = NULL;
+	proc->hermano_siguiente = *lista;
+	if (*lista != NULL)
+		(*lista)->hermano_anterior = proc;
+	*lista = proc;
+}
+
+/*
+ * Funcion que quita un BCP de una lista de hijos
+ */
+static void desenlazar_hijo(BCPptr *lista, BCP * proc)
+{
+	if (proc->hermano_anterior != NULL)
+		proc->hermano_anterior->hermano_siguiente = proc->hermano_siguiente;
+	else
+		*lista = proc->hermano_siguiente;
+	if (proc->hermano_siguiente != NULL)
+		proc->hermano_siguiente->hermano_anterior = proc->hermano_anterior;
+}
+
+/*
+ *
+ * Funciones relacionadas con la reserva de pilas de proceso:
+ *	iniciar_pilas reservar_pila devolver_pila
+ *
+ */
+
+/*
+ * Funcion que crea una pila nueva alineada a linea de cache
+ */
+static void * crear_pila_alineada()
+{
+	void *pila;
+
+	if (posix_memalign(&pila, TAM_LINEA_CACHE, TAM_PILA) != 0)
+		return NULL;
+	return pila;
+}
+
+/*
+ * Funcion que crea las pilas que se conservan siempre en la reserva
+ */
+static void iniciar_pilas()
+{
+	void *pila;
+
+	min_pilas_libres = leer_parametro_arranque("PILAS_INICIALES", MAX_PROC);
+	while (num_pilas_libres < min_pilas_libres)
+	{
+		if ((pila = crear_pila_alineada()) == NULL)
+			panico("no hay memoria para las pilas de proceso");
+		*(void **)pila = pilas_libres;
+		pilas_libres = pila;
+		num_pilas_libres++;
+	}
+}
+
+/*
+ * Funcion que entrega una pila de la reserva, creandola si no hay libres
+ */
+static void * reservar_pila()
+{
+	void *pila;
+
+	if (pilas_libres != NULL)
+	{
+		pila = pilas_libres;
+		pilas_libres = *(void **)pila;
+		num_pilas_libres--;
+	}
+	else if ((pila = crear_pila_alineada()) == NULL)
+		return NULL;
+
+	if (++pilas_en_uso > max_pilas_ventana)
+		max_pilas_ventana = pilas_en_uso;
+	if (pilas_en_uso > max_pilas_en_uso)
+		max_pilas_en_uso = pilas_en_uso;
+	return pila;
+}
+
+/*
+ * Funcion que devuelve una pila a la reserva. Una vez por segundo como
+ * mucho se liberan las libres que no harian falta para repetir el maximo
+ * de uso de la ultima ventana, conservando siempre min_pilas_libres. La
+ * pila devuelta se anade despues de recortar porque puede ser la que
+ * esta usando el propio kernel hasta el cambio de contexto.
+ */
+static void devolver_pila(void *pila)
+{
+	void *sobrante;
+	int conservar;
+
+	pilas_en_uso--;
+	if (ticks_sistema - inicio_ventana_pilas >= TICK)
+	{
+		conservar = max_pilas_ventana - pilas_en_uso;
+		if (conservar < min_pilas_libres)
+			conservar = min_pilas_libres;
+		while (num_pilas_libres > conservar)
+		{
+			sobrante = pilas_libres;
+			pilas_libres = *(void **)sobrante;
+			num_pilas_libres--;
+			free(sobrante);
+		}
+		PRINTK_DETALLE("-> PILAS: %d en uso, %d libres, maximo %d\n",
+			pilas_en_uso, num_pilas_libres, max_pilas_en_uso);
+		max_pilas_ventana = pilas_en_uso;
+		inicio_ventana_pilas = ticks_sistema;
+	}
+	*(void **)pila = pilas_libres;
+	pilas_libres = pila;
+	num_pilas_libres++;
+}
+
+/*
+ *
+ * Funciones relacionadas con la cache de imagenes de programa:
+ *	iniciar_cache_imagenes obtener_imagen referenciar_imagen soltar_imagen
+ *	descartar_imagen
+ *
+ * Cada imagen cargada cuenta como un proceso para el HAL, que termina el
+ * sistema cuando se libera la ultima: por eso al terminar el ultimo
+ * proceso se vacia la cache.
+ *
+ */
+
+/*
+ * Funcion hash (FNV-1a) sobre un nombre
+ */
+static unsigned int hash_nombre(char *nombre)
+{
+	unsigned int h = 2166136261u;
+
+	for(; *nombre != '\0'; nombre++)
+		h = (h ^ (unsigned char)*nombre) * 16777619u;
+
+	return h;
+}
+
+/*
+ * Funcion que fija cuantas imagenes sin usar conserva la cache
+ */
+static void iniciar_cache_imagenes()
+{
+	max_imagenes_lru = leer_parametro_arranque("IMAGENES_EN_CACHE", IMAGENES_EN_CACHE);
+}
+
+/*
+ * Quita una imagen de la lista LRU
+ */
+static void sacar_imagen_lru(imagen_ptr img)
+{
+	if (img->anterior_lru != NULL)
+		img->anterior_lru->siguiente_lru = img->siguiente_lru;
+	else
+		imagenes_lru_primera = img->siguiente_lru;
+	if (img->siguiente_lru != NULL)
+		img->siguiente_lru->anterior_lru = img->anterior_lru;
+	else
+		imagenes_lru_ultima = img->anterior_lru;
+	num_imagenes_lru--;
+}
+
+/*
+ * Elimina una imagen sin referencias de la cache y libera su mapa
+ */
+static void descartar_imagen(imagen_ptr img)
+{
+	imagen_ptr *enlace = &hash_imagenes[hash_nombre(img->nombre) & (TAM_HASH_IMAGENES-1)];
+
+	while (*enlace != img)
+		enlace = &(*enlace)->siguiente_hash;
+	*enlace = img->siguiente_hash;
+	sacar_imagen_lru(img);
+
+	PRINTK_DETALLE("-> DESCARTADA IMAGEN %s\n", img->nombre);
+	liberar_imagen(img->mem);	/* si es la ultima, el HAL termina aqui */
+	free(img);
+}
+
+/*
+ * Toma una referencia a una imagen
+ */
+static void referenciar_imagen(imagen_ptr img)
+{
+	img->referencias++;
+	referencias_imagenes++;
+}
+
+/*
+ * Devuelve una referencia a la imagen del programa, cargandolo solo si
+ * no esta en la cache. Devuelve NULL si no se puede crear.
+ */
+static imagen_ptr obtener_imagen(char *prog)
+{
+	unsigned int cubeta;
+	imagen_ptr img;
+
+	if (strlen(prog) > MAX_NOM_PROG)
+		return NULL;
+
+	cubeta = hash_nombre(prog) & (TAM_HASH_IMAGENES-1);
+	for (img = hash_imagenes[cubeta]; img != NULL; img = img->siguiente_hash)
+		if (strcmp(img->nombre, prog) == 0)
+			break;
+
+	if (img == NULL)
+	{
+		if ((img = malloc(sizeof(imagen))) == NULL)
+			return NULL;
+		if ((img->mem = crear_imagen(prog, &img->pc_inicial)) == NULL)
+		{
+			free(img);
+			return NULL;
+		}
+		strcpy(img->nombre, prog);
+		img->referencias = 0;
+		img->siguiente_hash = hash_imagenes[cubeta];
+		hash_imagenes[cubeta] = img;
+	}
+	else if (img->referencias == 0)
+		sacar_imagen_lru(img);
+
+	referenciar_imagen(img);
+	return img;
+}
+
+/*
+ * Libera una referencia a una imagen. Si no le quedan pasa a ser la mas
+ * recientemente usada de la lista LRU, descartando la menos reciente si
+ * se supera el maximo, o se vacia la cache si no queda ningun proceso.
+ */
+static void soltar_imagen(imagen_ptr img)
+{
+	referencias_imagenes--;
+	if (--img->referencias > 0)
+		return;
+
+	img->siguiente_lru = NULL;
+	img->anterior_lru = imagenes_lru_ultima;
+	if (imagenes_lru_ultima != NULL)
+		imagenes_lru_ultima->siguiente_lru = img;
+	else
+		imagenes_lru_primera = img;
+	imagenes_lru_ultima = img;
+	num_imagenes_lru++;
+
+	while (imagenes_lru_primera != NULL &&
+		(referencias_imagenes == 0 || num_imagenes_lru > max_imagenes_lru))
+		descartar_imagen(imagenes_lru_primera);
 }
 
 /*
  *
  * Funciones que facilitan el manejo de las listas de BCPs
- *	insertar_ultimo eliminar_primero eliminar_elem
+ *	insertar_ultimo eliminar_primero eliminar_elem concatenar_lista
  *
  * NOTA: PRIMERO SE DEBE LLAMAR A eliminar Y LUEGO A insertar
  */
@@ -100,11 +459,186 @@ static void eliminar_elem(lista_BCPs *lista, BCP * proc)
 	}
 }
 
+#if PLANIFICACION != PLANIF_CFS
+/*
+ * Mueve todos los BCPs de la lista origen al final de la lista destino,
+ * dejando origen vacia.
+ */
+static void concatenar_lista(lista_BCPs *destino, lista_BCPs *origen)
+{
+	if (origen->primero==NULL)
+		return;
+	if (destino->primero==NULL)
+		destino->primero=origen->primero;
+	else
+		destino->ultimo->siguiente=origen->primero;
+	destino->ultimo=origen->ultimo;
+	origen->primero=origen->ultimo=NULL;
+}
+#endif
+
 /*
  *
  * Funciones relacionadas con la planificacion
- *	espera_int planificador
+ *	insertar_listo eliminar_listo primero_listo insertar_listos espera_int
+ *	planificador
+ *
+ * Con PLANIF_MLFQ y PLANIF_PRIO el conjunto de listos son NUM_PRIORIDADES
+ * colas y un mapa de bits de las no vacias; con PLANIF_CFS, un monticulo
+ * ordenado por vruntime; con el resto, la lista lista_listos.
+ */
+
+#if PLANIFICACION == PLANIF_CFS
+/*
+ * Funciones del monticulo de listos: colocar_monticulo subir_monticulo
+ * bajar_monticulo
+ */
+static void colocar_monticulo(int pos, BCP * proc)
+{
+	monticulo_listos[pos]=proc;
+	proc->pos_monticulo=pos;
+}
+
+static void subir_monticulo(int pos)
+{
+	BCP * proc=monticulo_listos[pos];
+	int padre;
+
+	for ( ; pos>0; pos=padre)
+	{
+		padre=(pos-1)/2;
+		if (monticulo_listos[padre]->vruntime <= proc->vruntime)
+			break;
+		colocar_monticulo(pos, monticulo_listos[padre]);
+	}
+	colocar_monticulo(pos, proc);
+}
+
+static void bajar_monticulo(int pos)
+{
+	BCP * proc=monticulo_listos[pos];
+	int hijo;
+
+	for ( ; (hijo=2*pos+1)<num_listos; pos=hijo)
+	{
+		if (hijo+1<num_listos &&
+			monticulo_listos[hijo+1]->vruntime < monticulo_listos[hijo]->vruntime)
+			hijo++;
+		if (proc->vruntime <= monticulo_listos[hijo]->vruntime)
+			break;
+		colocar_monticulo(pos, monticulo_listos[hijo]);
+	}
+	colocar_monticulo(pos, proc);
+}
+
+/*
+ * Rodaja del proceso elegido: la latencia objetivo repartida entre los
+ * listos, con un minimo de GRANULARIDAD_MIN ticks
+ */
+static int rodaja_cfs()
+{
+	int rodaja=LATENCIA_OBJETIVO/num_listos;
+
+	return (rodaja<GRANULARIDAD_MIN) ? GRANULARIDAD_MIN : rodaja;
+}
+#endif
+
+/*
+ * Inserta un BCP al final de los listos de su prioridad
+ */
+static void insertar_listo(BCP * proc)
+{
+	proc->listo_desde = ticks_sistema;
+#if COLAS_PRIORIDAD
+	insertar_ultimo(&colas_listos[proc->prioridad], proc);
+	mapa_listos |= 1u << proc->prioridad;
+#elif PLANIFICACION == PLANIF_CFS
+	/* el que llega (nuevo o despertado) no puede ir por detras del resto */
+	if (proc->vruntime < vruntime_min)
+		proc->vruntime=vruntime_min;
+	colocar_monticulo(num_listos++, proc);
+	subir_monticulo(proc->pos_monticulo);
+#else
+	insertar_ultimo(&lista_listos, proc);
+#endif
+}
+
+/*
+ * Saca un BCP del conjunto de listos
+ */
+static void eliminar_listo(BCP * proc)
+{
+#if COLAS_PRIORIDAD
+	eliminar_elem(&colas_listos[proc->prioridad], proc);
+	if (colas_listos[proc->prioridad].primero==NULL)
+		mapa_listos &= ~(1u << proc->prioridad);
+#elif PLANIFICACION == PLANIF_CFS
+	int pos=proc->pos_monticulo;
+
+	if (pos!=--num_listos)
+	{
+		colocar_monticulo(pos, monticulo_listos[num_listos]);
+		subir_monticulo(pos);
+		bajar_monticulo(monticulo_listos[pos]->pos_monticulo);
+	}
+#else
+	eliminar_elem(&lista_listos, proc);
+#endif
+}
+
+/*
+ * Devuelve el primer BCP de la cola de listos mas prioritaria
+ */
+static BCP * primero_listo()
+{
+#if COLAS_PRIORIDAD
+	if (mapa_listos==0)
+		return NULL;
+	return colas_listos[__builtin_ctz(mapa_listos)].primero;
+#elif PLANIFICACION == PLANIF_CFS
+	return (num_listos>0) ? monticulo_listos[0] : NULL;
+#else
+	return lista_listos.primero;
+#endif
+}
+
+/*
+ * Pasa a listos todos los BCPs de una lista, dejandola vacia. Si todos
+ * van a la misma cola (siempre, salvo con colas de prioridad) la lista se
+ * engancha entera al final de ella; en otro caso, y en el monticulo de
+ * CFS, se insertan de uno en uno.
  */
+static void insertar_listos(lista_BCPs *grupo)
+{
+	BCP * proc;
+	BCP * siguiente;
+#if PLANIFICACION != PLANIF_CFS
+	int prioridad;
+
+	if ((proc = grupo->primero) == NULL)
+		return;
+	prioridad = proc->prioridad;
+	for ( ; proc != NULL && proc->prioridad == prioridad; proc = proc->siguiente)
+		proc->listo_desde = ticks_sistema;
+	if (proc == NULL)
+	{
+#if COLAS_PRIORIDAD
+		concatenar_lista(&colas_listos[prioridad], grupo);
+		mapa_listos |= 1u << prioridad;
+#else
+		concatenar_lista(&lista_listos, grupo);
+#endif
+		return;
+	}
+#endif
+
+	for (proc = grupo->primero; proc != NULL; proc = siguiente)
+	{
+		siguiente = proc->siguiente;
+		insertar_listo(proc);
+	}
+	grupo->primero = grupo->ultimo = NULL;
+}
 
 /*
  * Espera a que se produzca una interrupcion
@@ -122,39 +656,122 @@ static void espera_int()
 }
 
 /*
- * Funci�n de planificacion que implementa un algoritmo FIFO.
+ * Funci�n de planificacion: elige el primero de los listos segun la
+ * politica configurada (FIFO, RR, MLFQ o CFS).
+ * Todo cambio de p_proc_actual se hace con su resultado, por lo que
+ * tambien actualiza el proceso en ejecucion de la pagina del kernel y
+ * anula cualquier expulsion pendiente.
  */
 static BCP * planificador()
 {
-	while (lista_listos.primero==NULL)
+	BCP * proc;
+
+	while ((proc=primero_listo())==NULL)
 		espera_int();		/* No hay nada que hacer */
 		
-	return lista_listos.primero;
+	registrar_evento(EV_CAMBIO, (p_proc_actual!=NULL) ? p_proc_actual->id : -1, proc->id, 0);
+	proc->estadisticas.ticks_espera_listo += ticks_sistema - proc->listo_desde;
+#if PLANIFICACION == PLANIF_CFS
+	if (proc->vruntime > vruntime_min)
+		vruntime_min = proc->vruntime;
+	proc->tick_round_robin = rodaja_cfs();
+#endif
+	proc_a_expulsar = NULL;
+	pagina.actual = &(proc->datos_usuario);
+	pagina.cambios_proceso++;
+	return proc;
+}
+
+/*
+ * Funcion auxiliar que escribe lo que quede en el buffer de salida de
+ * usuario de un proceso, que la biblioteca no ha llegado a vaciar
+ */
+static void vaciar_salida(BCP *proc)
+{
+	if (proc->datos_usuario.num_salida>0)
+		escribir_ker(proc->datos_usuario.salida, proc->datos_usuario.num_salida);
+	proc->datos_usuario.num_salida=0;
 }
 
 /*
  *
  * Funcion auxiliar que termina proceso actual liberando sus recursos.
+ * Sus hijos se quedan sin padre y los que ya habian terminado se
+ * eliminan. Si su padre existe, el BCP se conserva como ZOMBI con el
+ * estado de salida hasta que lo espere, despertandolo si ya lo hacia.
+ * Antes cierra sus descriptores de mutex, semaforos, variables
+ * condicion, cerrojos de lectores/escritores y barreras, soltando lo que
+ * posea, de modo que nada queda retenido aunque muera por una excepcion.
  * Usada por llamada terminar_proceso y por rutinas que tratan excepciones
  *
  */
-static void liberar_proceso()
+static void liberar_proceso(int estado_salida)
 {
 	BCP * p_proc_anterior;
+	BCP * hijo;
+	BCP * padre;
+	int nivel_int, i;
+
+	for (i = 0; i<NUM_MUT_PROC; i++)
+		if (p_proc_actual->descriptores_mutex[i] != NULL)
+			liberar_mutex(i);
+
+	for (i = 0; i<NUM_SEM_PROC; i++)
+		if (p_proc_actual->descriptores_sem[i] != NULL)
+			liberar_sem(i);
+
+	for (i = 0; i<NUM_COND_PROC; i++)
+		if (p_proc_actual->descriptores_cond[i] != NULL)
+			liberar_cond(i);
+
+	for (i = 0; i<NUM_LE_PROC; i++)
+		if (p_proc_actual->descriptores_le[i] != NULL)
+			liberar_le(i);
+
+	for (i = 0; i<NUM_BAR_PROC; i++)
+		if (p_proc_actual->descriptores_bar[i] != NULL)
+			liberar_barrera(i);
 
-	liberar_imagen(p_proc_actual->info_mem); /* liberar mapa */
+	vaciar_salida(p_proc_actual); /* salida pendiente de la biblioteca */
+	soltar_imagen(p_proc_actual->imagen); /* liberar mapa */
 
-	p_proc_actual->estado=TERMINADO;
-	eliminar_primero(&lista_listos); /* proc. fuera de listos */
+	eliminar_listo(p_proc_actual); /* proc. fuera de listos */
+
+	for (hijo = p_proc_actual->hijos; hijo != NULL; hijo = hijo->hermano_siguiente)
+		hijo->padre = NULL;
+	while ((hijo = p_proc_actual->hijos_zombis) != NULL)
+	{
+		p_proc_actual->hijos_zombis = hijo->hermano_siguiente;
+		liberar_BCP(hijo);
+	}
+
+	padre = p_proc_actual->padre;
+	if (padre != NULL)
+	{
+		desenlazar_hijo(&padre->hijos, p_proc_actual);
+		enlazar_hijo(&padre->hijos_zombis, p_proc_actual);
+		p_proc_actual->estado = ZOMBI;
+		p_proc_actual->estado_salida = estado_salida;
+
+		if (padre->esperando_hijo.primero != NULL &&
+			(padre->hijo_esperado == -1 || padre->hijo_esperado == p_proc_actual->id))
+		{
+			nivel_int = fijar_nivel_int(3);
+			desbloquear_proceso(padre->esperando_hijo.primero, BLOQUEO_HIJO);
+			fijar_nivel_int(nivel_int);
+		}
+	}
+	else
+		liberar_BCP(p_proc_actual);
 
 	/* Realizar cambio de contexto */
 	p_proc_anterior=p_proc_actual;
 	p_proc_actual=planificador();
 
-	printk("-> C.CONTEXTO POR FIN: de %d a %d\n",
+	PRINTK_EVENTO("-> C.CONTEXTO POR FIN: de %d a %d\n",
 			p_proc_anterior->id, p_proc_actual->id);
 
-	liberar_pila(p_proc_anterior->pila);
+	devolver_pila(p_proc_anterior->pila);
 	cambio_contexto(NULL, &(p_proc_actual->contexto_regs));
         return; /* no deber�a llegar aqui */
 }
@@ -176,11 +793,13 @@ static void liberar_proceso()
 static void exc_arit()
 {
 
+	registrar_evento(EV_INTERRUPCION, p_proc_actual->id, EXC_ARITM, 0);
+
 	if (!viene_de_modo_usuario())
 		panico("excepcion aritmetica cuando estaba dentro del kernel");
 
-	printk("-> EXCEPCION ARITMETICA EN PROC %d\n", p_proc_actual->id);
-	liberar_proceso();
+	PRINTK_ERROR("-> EXCEPCION ARITMETICA EN PROC %d\n", p_proc_actual->id);
+	liberar_proceso(SALIDA_EXCEPCION);
 
         return; /* no deber�a llegar aqui */
 }
@@ -191,16 +810,30 @@ static void exc_arit()
 static void exc_mem()
 {
 
+	registrar_evento(EV_INTERRUPCION, p_proc_actual->id, EXC_MEM, 0);
+
 	if (!viene_de_modo_usuario())
 		panico("excepcion de memoria cuando estaba dentro del kernel");
 
 
-	printk("-> EXCEPCION DE MEMORIA EN PROC %d\n", p_proc_actual->id);
-	liberar_proceso();
+	PRINTK_ERROR("-> EXCEPCION DE MEMORIA EN PROC %d\n", p_proc_actual->id);
+	liberar_proceso(SALIDA_EXCEPCION);
 
         return; /* no deber�a llegar aqui */
 }
 
+/*
+ * Indica si hay datos suficientes en el buffer del terminal para una
+ * lectura en el modo indicado. En modo linea basta con que el buffer
+ * este lleno, ya que no podria llegar el fin de linea.
+ */
+static int hay_datos_terminal(int modo)
+{
+	if (modo == LEER_LINEA)
+		return buffer_terminal.num_lineas > 0 || es_buffer_lleno();
+	return !es_buffer_vacio();
+}
+
 /*
  * Tratamiento de interrupciones de terminal
  */
@@ -210,52 +843,130 @@ static void exc_mem()
 static void int_terminal()
 {
 	char car;
+	BCP * lector;
 
 	car = leer_puerto(DIR_TERMINAL);
-	printk("-> TRATANDO INT. DE TERMINAL %c\n", car);
+	registrar_evento(EV_INTERRUPCION, -1, INT_TERMINAL, car);
+	PRINTK_DETALLE("-> TRATANDO INT. DE TERMINAL %c\n", car);
 
-	if (!es_buffer_lleno()) //Si el buffer NO está lleno
+	if (es_buffer_lleno())	// ignora el caracter porque el buffer esta lleno
 	{
-		insertar_buffer(car);
+		buffer_terminal.perdidos++;
+		PRINTK_DETALLE("-> BUFFER DE TERMINAL LLENO: %lu perdidos\n", buffer_terminal.perdidos);
+		return;
+	}
+	insertar_buffer(car);
 
-		if(lista_bloqueados_terminal.primero!=NULL)
-			desbloquear_proceso(lista_bloqueados_terminal.primero, BLOQUEO_TERMINAL);		
+#if POLITICA_TERMINAL == TERMINAL_ENTREGA
+	/* entrega los datos a los lectores en espera por orden de llegada */
+	while ((lector = lista_bloqueados_terminal.primero) != NULL &&
+		hay_datos_terminal(lector->modo_terminal))
+	{
+		lector->leidos_terminal = copiar_buffer(lector->destino_terminal,
+			lector->max_terminal, lector->modo_terminal);
+		desbloquear_proceso(lector, BLOQUEO_TERMINAL);
 	}
-	//else -> ignora el caracter porque el buffer esta lleno
+#else
+	if (car == '\n' || es_buffer_lleno())
+		while ((lector = lista_bloqueados_terminal.primero) != NULL)
+			desbloquear_proceso(lector, BLOQUEO_TERMINAL);
+	else if (lista_bloqueados_terminal.primero != NULL)
+		desbloquear_proceso(lista_bloqueados_terminal.primero, BLOQUEO_TERMINAL);
+#endif
 }
 
-int sis_leer_caracter()
+/*
+ * Lee del terminal hasta max caracteres en destino segun el modo,
+ * bloqueando al proceso actual hasta que haya datos. Con la politica
+ * TERMINAL_ENTREGA un lector no se adelanta a los que ya esperan y, si se
+ * bloquea, vuelve con los datos ya copiados por int_terminal; con
+ * TERMINAL_DIFUSION compite con los demas al despertar. Devuelve cuantos
+ * caracteres ha leido.
+ */
+static int leer_terminal(char *destino, int max, int modo)
 {
-	char borrado;
-	int nivel_int;
+	int nivel_int, leidos;
+	BCP * p_proc_anterior;
 
-	if(es_buffer_vacio())		//si el buffer está vacio
-	{ 	
-		
-		nivel_int=fijar_nivel_int(2);
-		
-		bloquear_proceso(p_proc_actual, BLOQUEO_TERMINAL);
-		
-		BCP * p_proc_anterior;
-		p_proc_anterior=p_proc_actual;
-		p_proc_actual=planificador();
-		
+	nivel_int=fijar_nivel_int(NIVEL_2);
+#if POLITICA_TERMINAL == TERMINAL_ENTREGA
+	if (lista_bloqueados_terminal.primero == NULL && hay_datos_terminal(modo))
+	{
+		leidos = copiar_buffer(destino, max, modo);
 		fijar_nivel_int(nivel_int);
-
-		cambio_contexto(&(p_proc_anterior->contexto_regs), 				// cambio de contexto.		
-						&(p_proc_actual->contexto_regs));
+		return leidos;
 	}
 
-	borrado = borrar_buffer();
+	p_proc_actual->destino_terminal = destino;
+	p_proc_actual->max_terminal = max;
+	p_proc_actual->modo_terminal = modo;
+	bloquear_proceso(p_proc_actual, BLOQUEO_TERMINAL);
 
-	return (int)borrado;
-}
+	p_proc_anterior=p_proc_actual;
+	p_proc_actual=planificador();
+
+	fijar_nivel_int(nivel_int);
+
+	cambio_contexto(&(p_proc_anterior->contexto_regs), 				// cambio de contexto.		
+					&(p_proc_actual->contexto_regs));
+
+	return p_proc_actual->leidos_terminal;	/* int_terminal ya ha copiado los datos */
+#else
+	while (!hay_datos_terminal(modo))	/* otro lector puede haberse adelantado */
+	{
+		bloquear_proceso(p_proc_actual, BLOQUEO_TERMINAL);
+		
+		p_proc_anterior=p_proc_actual;
+		p_proc_actual=planificador();
+		
+		fijar_nivel_int(nivel_int);
+
+		cambio_contexto(&(p_proc_anterior->contexto_regs), 				// cambio de contexto.		
+						&(p_proc_actual->contexto_regs));
+
+		nivel_int=fijar_nivel_int(NIVEL_2);
+	}
+	leidos = copiar_buffer(destino, max, modo);
+	fijar_nivel_int(nivel_int);
+	return leidos;
+#endif
+}
+
+int sis_leer_caracter()
+{
+	char car;
+
+	leer_terminal(&car, 1, LEER_CARACTERES);
+	return (int)car;
+}
+
+/*
+ * Tratamiento de llamada al sistema leer. Copia en la direccion que
+ * recibe en el registro 1 hasta tantos caracteres como indica el
+ * registro 2. En modo LEER_CARACTERES (registro 3) se bloquea hasta que
+ * haya alguno y devuelve todos los disponibles; en modo LEER_LINEA, hasta
+ * que haya una linea completa, y devuelve hasta su '\n' inclusive.
+ * Devuelve el numero de caracteres copiados.
+ */
+int sis_leer()
+{
+	char *destino = (char *)leer_registro(1);
+	int max = (int)leer_registro(2);
+	int modo = (int)leer_registro(3);
+
+	if (destino == NULL || max <= 0 || (modo != LEER_CARACTERES && modo != LEER_LINEA))
+		return -1;
+
+	return leer_terminal(destino, max, modo);
+}
 
 void insertar_buffer(char car)
 {
 	buffer_terminal.num_elementos++;
+	if (car == '\n')
+		buffer_terminal.num_lineas++;
 	buffer_terminal.buffer_terminal[buffer_terminal.in_insertar] = car;
-	buffer_terminal.in_insertar =(buffer_terminal.in_insertar +1)%TAM_BUF_TERM;
+	buffer_terminal.in_insertar = (buffer_terminal.in_insertar + 1) & buffer_terminal.mascara;
 }
 
 char borrar_buffer ()
@@ -267,9 +978,10 @@ char borrar_buffer ()
 	{
 		borrado = buffer_terminal.buffer_terminal[buffer_terminal.in_borrar];
 
-		buffer_terminal.buffer_terminal[buffer_terminal.in_borrar] = '\0';	
-		buffer_terminal.in_borrar = (buffer_terminal.in_borrar + 1)%TAM_BUF_TERM;
+		buffer_terminal.in_borrar = (buffer_terminal.in_borrar + 1) & buffer_terminal.mascara;
 		buffer_terminal.num_elementos--;
+		if (borrado == '\n')
+			buffer_terminal.num_lineas--;
 	}
 	else
 		borrado = '\0';
@@ -277,13 +989,51 @@ char borrar_buffer ()
 	return borrado;
 }
 
+/*
+ * Retira del buffer hasta max caracteres copiandolos en destino. En modo
+ * LEER_LINEA se detiene despues del primer '\n'. Devuelve cuantos copia.
+ */
+int copiar_buffer(char *destino, int max, int modo)
+{
+	unsigned int tramo, n, i;
+	char *origen;
+
+	n = buffer_terminal.num_elementos;
+	if (n > (unsigned int)max)
+		n = max;
+
+	if (modo == LEER_LINEA && buffer_terminal.num_lineas > 0)
+		for (i = 0; i < n; i++)
+			if (buffer_terminal.buffer_terminal[(buffer_terminal.in_borrar + i) & buffer_terminal.mascara] == '\n')
+			{
+				n = i + 1;
+				break;
+			}
+
+	/* como mucho dos tramos: hasta el final del vector y desde el principio */
+	origen = &buffer_terminal.buffer_terminal[buffer_terminal.in_borrar];
+	tramo = buffer_terminal.mascara + 1 - buffer_terminal.in_borrar;
+	if (tramo > n)
+		tramo = n;
+	memcpy(destino, origen, tramo);
+	memcpy(destino + tramo, buffer_terminal.buffer_terminal, n - tramo);
+
+	for (i = 0; i < n; i++)
+		if (destino[i] == '\n')
+			buffer_terminal.num_lineas--;
+
+	buffer_terminal.in_borrar = (buffer_terminal.in_borrar + n) & buffer_terminal.mascara;
+	buffer_terminal.num_elementos -= n;
+	return n;
+}
+
 /*
  * Devuelve 1 si el buffer SÍ está lleno
  * Devuelve 0 si el buffer NO está lleno 
  */
 int es_buffer_lleno()
 {
-	return buffer_terminal.num_elementos == TAM_BUF_TERM;
+	return buffer_terminal.num_elementos == buffer_terminal.mascara + 1;
 }
 
 /*
@@ -296,17 +1046,24 @@ int es_buffer_vacio()
 }
 
 /**
- * Inicializa el buffer con caracteres vacíos
+ * Reserva el buffer, con el tamano fijado en el arranque redondeado a
+ * potencia de 2, y lo deja vacio
  */
 static void iniciar_buffer()
 {
-	int i = 0;
-	for(;i<TAM_BUF_TERM;i++)
-	{
-		buffer_terminal.buffer_terminal[i] = '\0';
-	}
+	unsigned int tam;
+	int pedido = leer_parametro_arranque("TAM_BUF_TERM", TAM_BUF_TERM);
+
+	for (tam = 1; tam < (unsigned int)pedido; tam <<= 1);
 
+	buffer_terminal.buffer_terminal = malloc(tam);
+	if (buffer_terminal.buffer_terminal == NULL)
+		panico("no hay memoria para el buffer del terminal");
+
+	buffer_terminal.mascara = tam - 1;
 	buffer_terminal.num_elementos = 0;
+	buffer_terminal.num_lineas = 0;
+	buffer_terminal.perdidos = 0;
 	buffer_terminal.in_borrar = 0;
 	buffer_terminal.in_insertar = 0;
 }
@@ -316,8 +1073,16 @@ static void iniciar_buffer()
  */
 static void int_sw()
 {
-	printk("-> TRATANDO INT. SW\n");
-	imprimir_lista(lista_listos);
+	PRINTK_DETALLE("-> TRATANDO INT. SW\n");
+	registrar_evento(EV_INTERRUPCION, -1, INT_SW, 0);
+
+	/* El proceso a expulsar puede haber dejado ya la UCP por si mismo */
+	if (proc_a_expulsar==NULL || proc_a_expulsar!=p_proc_actual)
+		return;
+
+#if NIVEL_TRAZA >= TRAZA_DETALLE
+	imprimir_listos();
+#endif
 	inter_sw_fin_rodaja_RR();
 	return;
 }
@@ -325,12 +1090,11 @@ static void int_sw()
 void inter_sw_fin_rodaja_RR()
 {
 	
-	int nivel_int = fijar_nivel_int(1);
+	int nivel_int = fijar_nivel_int(3);
 
 	BCP * proc_a_bloquear=p_proc_actual;
-	proc_a_bloquear->tick_round_robin = TICKS_POR_RODAJA;
 	
-	printk("Proceso (%d): se bloquea.\n", p_proc_actual->id);
+	PRINTK_DETALLE("Proceso (%d): se bloquea.\n", p_proc_actual->id);
 	bloquear_proceso(proc_a_bloquear, BLOQUEO_RR);
 
 	p_proc_actual=planificador();
@@ -341,70 +1105,245 @@ void inter_sw_fin_rodaja_RR()
 					&(p_proc_actual->contexto_regs));
 }
 
+/*
+ * Descuenta un tick de la rodaja del proceso actual y, si la ha agotado o
+ * (con MLFQ o PRIO) hay listo uno mas prioritario o (con CFS) uno que lleva
+ * mas de GRANULARIDAD_MIN ticks de retraso, pide su expulsion con una
+ * interrupcion software para hacerla al volver a modo usuario.
+ */
 void comprobar_fin_rodaja_RR()
 {
-	if (p_proc_actual->tick_round_robin == 0)	// Si no tiene llamamos a la interrupción software.
-		int_sw();								
-	else{
+	/* Durante espera_int el proceso actual esta bloqueado */
+	if (p_proc_actual==NULL || p_proc_actual->estado!=LISTO)
+		return;
+
+	if (p_proc_actual->tick_round_robin > 0)
 		p_proc_actual->tick_round_robin--;		// Si tiene le restamos 1.
-	}	
+
+#if PLANIFICACION == PLANIF_CFS
+	p_proc_actual->vruntime++;					// su clave crece: se recoloca.
+	bajar_monticulo(p_proc_actual->pos_monticulo);
+#endif
+
+	if (p_proc_actual->tick_round_robin == 0
+#if COLAS_PRIORIDAD
+		|| (int)__builtin_ctz(mapa_listos) < p_proc_actual->prioridad
+#elif PLANIFICACION == PLANIF_CFS
+		|| monticulo_listos[0]->vruntime + GRANULARIDAD_MIN < p_proc_actual->vruntime
+#endif
+		)
+	{
+		proc_a_expulsar = p_proc_actual;
+		activar_int_SW();
+	}
+}
+
+#if PLANIFICACION == PLANIF_PRIO
+/*
+ * Pide la expulsion del proceso actual si hay listo uno mas prioritario,
+ * sin esperar al siguiente tick. Se usa al despertar a un proceso y al
+ * bajar la prioridad del actual.
+ */
+static void expulsar_si_prioritario()
+{
+	if (p_proc_actual!=NULL && p_proc_actual->estado==LISTO &&
+		(int)__builtin_ctz(mapa_listos) < p_proc_actual->prioridad)
+	{
+		proc_a_expulsar = p_proc_actual;
+		activar_int_SW();
+	}
+}
+#endif
+
+#if PLANIFICACION == PLANIF_MLFQ
+/*
+ * Sube todos los procesos al nivel de maxima prioridad para evitar la
+ * inanicion de los que han ido bajando de nivel.
+ */
+static void impulsar_prioridades()
+{
+	int i;
+
+	for (i=1; i<NUM_PRIORIDADES; i++)
+		concatenar_lista(&colas_listos[0], &colas_listos[i]);
+	mapa_listos = (colas_listos[0].primero!=NULL) ? 1u : 0;
+
+	for (i=0; i<tam_tabla_procs; i++)
+		if (tabla_procs[i]->estado!=NO_USADA)
+		{
+			tabla_procs[i]->prioridad = 0;
+			tabla_procs[i]->tick_round_robin = TICKS_RODAJA(0);
+		}
+}
+
+/*
+ * Sube un nivel a un proceso que se bloquea en espera de un evento
+ * (dormir, leer_caracter). Debe estar fuera de las colas de listos.
+ */
+static void promocionar_proceso(BCP * proceso)
+{
+	if (proceso->prioridad > 0)
+	{
+		proceso->prioridad--;
+		proceso->tick_round_robin = TICKS_RODAJA(proceso->prioridad);
+	}
+}
+#endif
+
+/*
+ * Funcion auxiliar que lee el reloj monotono de la maquina anfitriona en
+ * nanosegundos, ya que el HAL no ofrece uno mas fino que el tick
+ */
+static unsigned long reloj_ns()
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (unsigned long)t.tv_sec*1000000000UL + t.tv_nsec;
 }
 
 /*
- * Tratamiento de interrupciones de reloj
+ * Tratamiento de interrupciones de reloj. Acumula en la pagina del kernel
+ * el tiempo que dedica a cada tick.
  */
 static void int_reloj()
 {
+	unsigned long inicio_ns = reloj_ns();
 
-	printk("-> TRATANDO INT. DE RELOJ\n");
+	PRINTK_DETALLE("-> TRATANDO INT. DE RELOJ\n");
 
-	/* 
-	 * Comprobamos si el proceso actual tiene ticks que ejecutar.
-	 * Para probar Round Robin 1, descomentar.
-	 * Para probar cualquier otro, comentar.
-	 */
-	//comprobar_fin_rodaja_RR();
-	
-	// Actualizar tiempos de los proceso dormidos.
-	actualizar_tiempos();
+	ticks_sistema++;
+	pagina.ticks = ticks_sistema;
+	registrar_evento(EV_INTERRUPCION, -1, INT_RELOJ, 0);
+
+	// Contabilidad del tick en el proceso actual (no si la UCP esta ociosa).
+	if (p_proc_actual!=NULL && p_proc_actual->estado==LISTO)
+	{
+		if (viene_de_modo_usuario())
+			p_proc_actual->estadisticas.ticks_modo_usuario++;
+		else
+			p_proc_actual->estadisticas.ticks_modo_sistema++;
+	}
+
+	// Despertar los procesos dormidos cuyo plazo vence en este tick.
+	avanzar_rueda();
+
+#if PLANIFICACION != PLANIF_FIFO
+	// Comprobamos si el proceso actual tiene ticks que ejecutar.
+	comprobar_fin_rodaja_RR();
+#endif
+#if PLANIFICACION == PLANIF_MLFQ
+	if (ticks_sistema % TICKS_IMPULSO == 0)
+		impulsar_prioridades();
+#endif
 
+	pagina.ns_reloj += reloj_ns() - inicio_ns;
     return;
 }
 
-void actualizar_tiempos(){
-	BCP * BCPptr_recorredor;
-	BCPptr_recorredor = lista_bloqueados_dormir.primero;
+/*
+ * Recorre la ranura de la rueda de temporizacion correspondiente al tick
+ * actual y despierta los procesos cuyo plazo ha vencido. Los BCPs que
+ * caen en la ranura pero vencen en una vuelta posterior se dejan en ella.
+ */
+void avanzar_rueda()
+{
+	lista_BCPs *ranura = &rueda_dormir[ticks_sistema & (TAM_RUEDA-1)];
+	BCP * BCPptr_anterior = NULL;
+	BCP * BCPptr_recorredor = ranura->primero;
+	BCP * BCPptr_siguiente;
 
 	while(BCPptr_recorredor!=NULL)
-	{	
-		//printk("Proceso(%d) Dormido, despierta en: (%d) TICKS\n", BCPptr_recorredor->id, BCPptr_recorredor->despertar_en);
-		if(BCPptr_recorredor->despertar_en <= 0)
+	{
+		BCPptr_siguiente = BCPptr_recorredor->siguiente;
+
+		if(BCPptr_recorredor->despertar_en <= ticks_sistema)
 		{
-			if(BCPptr_recorredor==lista_bloqueados_dormir.primero)		// Si ha llegado a cero, y es el primero.
-			{					
-				if(BCPptr_recorredor->siguiente != NULL)
-					BCPptr_recorredor->siguiente->despertar_en = BCPptr_recorredor->siguiente->despertar_en - 1;
-
-				desbloquear_proceso(BCPptr_recorredor, BLOQUEO_DORMIR);
-				
-				if(lista_bloqueados_dormir.primero!=NULL)
-					BCPptr_recorredor = lista_bloqueados_dormir.primero;
-				else
-					return;
-			}
+			// Se desengancha aqui para no volver a recorrer la ranura.
+			if(BCPptr_anterior==NULL)
+				ranura->primero = BCPptr_siguiente;
 			else
-			{	
-				if(BCPptr_recorredor->siguiente != NULL)
-					BCPptr_recorredor->siguiente->despertar_en = BCPptr_recorredor->siguiente->despertar_en - 1;
+				BCPptr_anterior->siguiente = BCPptr_siguiente;
+			if(ranura->ultimo==BCPptr_recorredor)
+				ranura->ultimo = BCPptr_anterior;
 
-				desbloquear_proceso(BCPptr_recorredor, BLOQUEO_DORMIR);	
-			}		
+			desbloquear_proceso(BCPptr_recorredor, BLOQUEO_DORMIR);
 		}
 		else
-			BCPptr_recorredor->despertar_en = BCPptr_recorredor->despertar_en - 1;	// Reducimos en 1 tick el tiempo que tiene que esperar.
-			
-		BCPptr_recorredor = BCPptr_recorredor->siguiente;
+			BCPptr_anterior = BCPptr_recorredor;
+
+		BCPptr_recorredor = BCPptr_siguiente;
+	}
+}
+
+/*
+ * Registra un evento en el buffer circular de traza. La entrada se
+ * reserva con un incremento atomico, por lo que no hace falta elevar el
+ * nivel de interrupcion aunque lo interrumpa otro manejador que tambien
+ * registre. Como en un seqlock, la secuencia se anula antes de escribir
+ * el evento y se fija la ultima, para que leer_traza pueda descartar una
+ * entrada a medio escribir.
+ */
+void registrar_evento(int tipo, int id, int arg, long valor)
+{
+	unsigned long n = __sync_fetch_and_add(&traza_escritos, 1);
+	evento_traza *ev = &traza[n & (TAM_TRAZA-1)];
+
+	ev->secuencia = 0;
+	__sync_synchronize();
+	ev->tick = ticks_sistema;
+	ev->tipo = tipo;
+	ev->id = id;
+	ev->arg = arg;
+	ev->valor = valor;
+	__sync_synchronize();
+	ev->secuencia = n + 1;
+}
+
+/*
+ * Funcion auxiliar que anota en las estadisticas de la llamada nserv una
+ * ejecucion con el resultado y la duracion indicados
+ */
+static void contar_llamada(int nserv, int res, unsigned long ticks, unsigned long ns)
+{
+	estadisticas_llamada *est = &estadisticas_llamadas[nserv];
+	int cubeta;
+
+	cubeta = (ns > 0) ? 63 - __builtin_clzl(ns) : 0;
+	if (cubeta >= CUBETAS_LATENCIA)
+		cubeta = CUBETAS_LATENCIA-1;
+
+	est->llamadas++;
+	if (res < 0)
+		est->errores++;
+	est->ticks += ticks;
+	est->ns += ns;
+	est->cubetas[cubeta]++;
+}
+
+/*
+ * Funcion auxiliar que ejecuta el servicio nserv con los argumentos que
+ * ya estan en los registros 1, 2, ... y devuelve su resultado
+ */
+static int ejecutar_servicio(int nserv)
+{
+	int res;
+	unsigned long inicio_ticks, inicio_ns;
+
+	registrar_evento(EV_LLAMADA, p_proc_actual->id, nserv, 0);
+	pagina.llamadas++;
+	if (nserv>=0 && nserv<NSERVICIOS)
+	{
+		inicio_ticks=ticks_sistema;
+		inicio_ns=reloj_ns();
+		res=(tabla_servicios[nserv].fservicio)();
+		contar_llamada(nserv, res, ticks_sistema-inicio_ticks,
+			reloj_ns()-inicio_ns);
 	}
+	else
+		res=-1;		/* servicio no existente */
+	registrar_evento(EV_FIN_LLAMADA, p_proc_actual->id, nserv, res);
+	return res;
 }
 
 /*
@@ -415,10 +1354,7 @@ static void tratar_llamsis()
 	int nserv, res;
 
 	nserv=leer_registro(0);
-	if (nserv<NSERVICIOS)
-		res=(tabla_servicios[nserv].fservicio)();
-	else
-		res=-1;		/* servicio no existente */
+	res=ejecutar_servicio(nserv);
 	escribir_registro(0,res);
 	return;
 }
@@ -426,51 +1362,113 @@ static void tratar_llamsis()
 
 /*
  *
- * Funcion auxiliar que crea un proceso reservando sus recursos.
- * Usada por llamada crear_proceso.
+ * Funcion auxiliar que crea un proceso a partir de una imagen ya cargada,
+ * tomando una referencia a ella, y lo pone en la cola de listos.
+ * Devuelve su BCP o NULL si no hay entrada libre o pila.
  *
  */
-static int crear_tarea(char *prog)
+static BCP * crear_tarea_imagen(imagen_ptr imagen)
 {
-	void * imagen, *pc_inicial;
-	int error=0;
-	int proc;
 	BCP *p_proc;
 
-	proc=buscar_BCP_libre();
-	if (proc==-1)
-		return -1;	/* no hay entrada libre */
-
 	/* A rellenar el BCP ... */
-	p_proc=&(tabla_procs[proc]);
+	p_proc=buscar_BCP_libre();
+	if (p_proc==NULL)
+		return NULL;	/* no hay entrada libre */
 
-	/* crea la imagen de memoria leyendo ejecutable */
-	imagen=crear_imagen(prog, &pc_inicial);
-	if (imagen)
+	if ((p_proc->pila=reservar_pila())==NULL)
 	{
-		p_proc->info_mem=imagen;
-		p_proc->pila=crear_pila(TAM_PILA);
-		fijar_contexto_ini(p_proc->info_mem, p_proc->pila, TAM_PILA,
-			pc_inicial,
-			&(p_proc->contexto_regs));
-		p_proc->id=proc;
-		p_proc->estado=LISTO;
-		p_proc->tick_round_robin = TICKS_POR_RODAJA;		// <---------------------esto es nuevo
+		liberar_BCP(p_proc);
+		return NULL;	/* no hay pila */
+	}
+
+	referenciar_imagen(imagen);
+	p_proc->imagen=imagen;
+	p_proc->padre=p_proc_actual;	/* NULL para el proceso inicial */
+	p_proc->hijos=NULL;
+	p_proc->hijos_zombis=NULL;
+	p_proc->esperando_hijo.primero=p_proc->esperando_hijo.ultimo=NULL;
+	if (p_proc_actual!=NULL)
+		enlazar_hijo(&p_proc_actual->hijos, p_proc);
+	p_proc->info_mem=imagen->mem;
+	fijar_contexto_ini(p_proc->info_mem, p_proc->pila, TAM_PILA,
+		imagen->pc_inicial,
+		&(p_proc->contexto_regs));
+	p_proc->datos_usuario.id=p_proc->id;
+	memset(p_proc->descriptores_mutex, 0, sizeof(p_proc->descriptores_mutex));
+	memset(p_proc->datos_usuario.cerrojos, 0, sizeof(p_proc->datos_usuario.cerrojos));
+	memset(p_proc->descriptores_sem, 0, sizeof(p_proc->descriptores_sem));
+	memset(p_proc->descriptores_cond, 0, sizeof(p_proc->descriptores_cond));
+	memset(p_proc->descriptores_le, 0, sizeof(p_proc->descriptores_le));
+	memset(p_proc->descriptores_bar, 0, sizeof(p_proc->descriptores_bar));
+	memset(p_proc->datos_usuario.cerrojos_le, 0, sizeof(p_proc->datos_usuario.cerrojos_le));
+	memset(p_proc->datos_usuario.lecturas_le, 0, sizeof(p_proc->datos_usuario.lecturas_le));
+	p_proc->datos_usuario.modo_salida=SALIDA_LINEA;
+	p_proc->datos_usuario.num_salida=0;
+	p_proc->estado=LISTO;
+	p_proc->prioridad_base = (p_proc_actual!=NULL) ? p_proc_actual->prioridad_base : 0;
+	p_proc->prioridad = p_proc->prioridad_base;
+	p_proc->tick_round_robin = TICKS_RODAJA(0);
+	p_proc->vruntime = 0;
+	memset(&p_proc->estadisticas, 0, sizeof(p_proc->estadisticas));
+	p_proc->estadisticas.id = p_proc->id;
+
+	/* lo inserta al final de cola de listos */
+	insertar_listo(p_proc);
+	return p_proc;
+}
+
+/*
+ *
+ * Funcion auxiliar que crea n procesos del mismo programa, cargando su
+ * imagen una sola vez. Deja en ids el id de cada uno o -1 si no se ha
+ * podido crear. Devuelve cuantos ha creado o -1 si falla la imagen.
+ * Usada por llamadas crear_proceso y crear_procesos.
+ *
+ */
+static int crear_tareas(char *prog, int n, int *ids)
+{
+	imagen_ptr imagen;
+	BCP *p_proc;
+	int i, creados=0;
 
-		/* lo inserta al final de cola de listos */
-		insertar_ultimo(&lista_listos, p_proc);
-		error= 0;
+	/* obtiene la imagen de memoria, leyendo el ejecutable si no esta en cache */
+	imagen=obtener_imagen(prog);
+	if (imagen==NULL)
+		return -1;	/* fallo al crear imagen */
+
+	for (i=0; i<n; i++)
+	{
+		p_proc=crear_tarea_imagen(imagen);
+		if (p_proc!=NULL)
+			creados++;
+		if (ids!=NULL)
+			ids[i]=(p_proc!=NULL) ? p_proc->id : -1;
 	}
-	else
-		error= -1; /* fallo al crear imagen */
 
-	return error;
+	soltar_imagen(imagen);	/* cada proceso tiene su propia referencia */
+	return creados;
+}
+
+/*
+ *
+ * Funcion auxiliar que crea un proceso reservando sus recursos.
+ * Devuelve su id o -1 si no se ha podido crear.
+ * Usada por llamada crear_proceso.
+ *
+ */
+static int crear_tarea(char *prog)
+{
+	int id;
+
+	return (crear_tareas(prog, 1, &id)==1) ? id : -1;
 }
 
 /*
  *
  * Rutinas que llevan a cabo las llamadas al sistema
- *	sis_crear_proceso sis_escribir
+ *	sis_crear_proceso sis_crear_procesos sis_escribir sis_escribirv
+ *	sis_procesar_anillo
  *
  */
 
@@ -483,13 +1481,34 @@ int sis_crear_proceso()
 	char *prog;
 	int res;
 
-	printk("-> PROC %d: CREAR PROCESO\n", p_proc_actual->id);
+	PRINTK_EVENTO("-> PROC %d: CREAR PROCESO\n", p_proc_actual->id);
 	prog=(char *)leer_registro(1);
 	res=crear_tarea(prog);
 	
 	return res;
 }
 
+/*
+ * Tratamiento de llamada al sistema crear_procesos. Crea tantos procesos
+ * como indica el registro 2 del programa cuyo nombre recibe en el
+ * registro 1, y deja el id de cada uno (o -1) en el vector que recibe en
+ * el registro 3. Devuelve cuantos ha creado.
+ */
+int sis_crear_procesos()
+{
+	char *prog;
+	int n, *ids;
+
+	prog=(char *)leer_registro(1);
+	n=(int)leer_registro(2);
+	ids=(int *)leer_registro(3);
+	PRINTK_EVENTO("-> PROC %d: CREAR %d PROCESOS\n", p_proc_actual->id, n);
+
+	if (n<0 || ids==NULL)
+		return -1;
+	return crear_tareas(prog, n, ids);
+}
+
 /*
  * Tratamiento de llamada al sistema escribir. Llama simplemente a la
  * funcion de apoyo escribir_ker
@@ -507,33 +1526,172 @@ int sis_escribir()
 }
 
 /*
- * Tratamiento de llamada al sistema terminar_proceso. Llama a la
- * funcion auxiliar liberar_proceso y cierra los mutex asociados a ese proceso
+ * Tratamiento de llamada al sistema escribirv. Escribe en orden los
+ * fragmentos del vector que recibe en el registro 1, con tantos elementos
+ * como indica el registro 2. Devuelve el total de bytes escritos, o -1
+ * sin escribir nada si algun fragmento no tiene texto o su longitud es
+ * negativa (o el total no cabe en el resultado).
  */
-int sis_terminar_proceso()
+int sis_escribirv()
 {
-	int i, resultado; 
-	printk("-> FIN PROCESO %d\n", p_proc_actual->id);
+	fragmento *frag;
+	int i, n, total=0;
 
-	mutex_ptr mutex_recorredor;
+	frag=(fragmento *)leer_registro(1);
+	n=(int)leer_registro(2);
 
-	for (i = 0; i<NUM_MUT_PROC;i++)
+	if (frag==NULL || n<0)
+		return -1;
+	for (i=0; i<n; i++)
 	{
-		mutex_recorredor = p_proc_actual->descriptores_mutex[i];
-		if (mutex_recorredor != NULL){
+		if (frag[i].texto==NULL || (int)frag[i].longi<0 ||
+			(int)frag[i].longi>INT_MAX-total)
+			return -1;
+		total+=frag[i].longi;
+	}
+	for (i=0; i<n; i++)
+		escribir_ker(frag[i].texto, frag[i].longi);
+	return total;
+}
+
+/*
+ * Tratamiento de llamada al sistema procesar_anillo. Ejecuta en orden las
+ * peticiones pendientes del anillo que recibe en el registro 1, poniendo
+ * sus argumentos en los registros como si cada una fuera una llamada, y
+ * deja los resultados en su cola de finalizaciones, parando si esta se
+ * llena. Una peticion que bloquea al proceso retrasa las siguientes hasta
+ * que se desbloquee. Devuelve el numero de peticiones ejecutadas.
+ */
+int sis_procesar_anillo()
+{
+	anillo_llamadas *anillo;
+	peticion pet;
+	finalizacion *fin;
+	int i, res, n=0;
+
+	anillo=(anillo_llamadas *)leer_registro(1);
+	if (anillo==NULL)
+		return -1;
 
-			p_proc_actual->descriptores_mutex[i]->num_bloqueos=0;
-			resultado = aux_unlock_mutex(i);
-			if (p_proc_actual ->descriptores_mutex[i]->num_procesos_bloqueados == 0)
-				liberar_mutex(i);
-		}	
+	while (anillo->sub_cabeza!=anillo->sub_cola &&
+			anillo->fin_cola-anillo->fin_cabeza<TAM_ANILLO)
+	{
+		/* se copia y se consume antes de ejecutarla, por si no vuelve */
+		pet=anillo->peticiones[anillo->sub_cabeza & (TAM_ANILLO-1)];
+		anillo->sub_cabeza++;
+
+		for (i=0; i<ARGS_PETICION; i++)
+			escribir_registro(i+1, pet.args[i]);
+		if (pet.llamada==PROCESAR_ANILLO)
+			res=-1;
+		else
+			res=ejecutar_servicio(pet.llamada);
+
+		fin=&anillo->finalizaciones[anillo->fin_cola & (TAM_ANILLO-1)];
+		fin->llamada=pet.llamada;
+		fin->resultado=res;
+		fin->dato=pet.dato;
+		anillo->fin_cola++;
+		n++;
 	}
+	return n;
+}
 
-	liberar_proceso();
+/*
+ * Tratamiento de llamada al sistema terminar_proceso. Llama a la
+ * funcion auxiliar liberar_proceso con el estado de salida que recibe en
+ * el registro 1
+ */
+int sis_terminar_proceso()
+{
+	int resultado;
+	int estado_salida = (int)leer_registro(1);
+	PRINTK_EVENTO("-> FIN PROCESO %d\n", p_proc_actual->id);
+
+	liberar_proceso(estado_salida);
 	resultado = 0;
     return resultado; /* no deber�a llegar aqui */
 }
 
+/*
+ * Funcion auxiliar que espera a que termine el hijo con el id indicado
+ * (o cualquiera si es -1) bloqueando al proceso en su cola esperando_hijo.
+ * Elimina el hijo, deja su estado de salida en estado (si no es NULL) y
+ * devuelve su id, o -1 si no es hijo suyo o no tiene hijos.
+ */
+static int esperar_hijo(int id, int *estado)
+{
+	BCP * hijo;
+	BCP * p_proc_anterior;
+	int nivel_int;
+
+	for (;;)
+	{
+		if (id == -1)
+		{
+			hijo = p_proc_actual->hijos_zombis;
+			if (hijo == NULL && p_proc_actual->hijos == NULL)
+				return -1;
+		}
+		else
+		{
+			hijo = buscar_BCP(id);
+			if (hijo == NULL || hijo->padre != p_proc_actual)
+				return -1;
+			if (hijo->estado != ZOMBI)
+				hijo = NULL;
+		}
+
+		if (hijo != NULL)
+			break;
+
+		p_proc_actual->hijo_esperado = id;
+		nivel_int = fijar_nivel_int(3);
+
+		bloquear_proceso(p_proc_actual, BLOQUEO_HIJO);
+
+		p_proc_anterior = p_proc_actual;
+		p_proc_actual = planificador();
+
+		fijar_nivel_int(nivel_int);
+
+		cambio_contexto(&(p_proc_anterior->contexto_regs),
+						&(p_proc_actual->contexto_regs));
+	}
+
+	id = hijo->id;
+	if (estado != NULL)
+		*estado = hijo->estado_salida;
+	desenlazar_hijo(&p_proc_actual->hijos_zombis, hijo);
+	liberar_BCP(hijo);
+	return id;
+}
+
+/*
+ * Tratamiento de llamada al sistema esperar_proceso. Espera a que termine
+ * el hijo cuyo id recibe en el registro 1 y deja su estado de salida en
+ * la direccion que recibe en el registro 2 (si no es NULL).
+ */
+int sis_esperar_proceso()
+{
+	int id = (int)leer_registro(1);
+	int *estado = (int *)leer_registro(2);
+
+	if (id < 0)
+		return -1;
+	return (esperar_hijo(id, estado) < 0) ? -1 : 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema esperar_cualquiera. Espera a que
+ * termine cualquier hijo y deja su estado de salida en la direccion que
+ * recibe en el registro 1 (si no es NULL). Devuelve el id del hijo.
+ */
+int sis_esperar_cualquiera()
+{
+	return esperar_hijo(-1, (int *)leer_registro(1));
+}
+
 /*
  * Tratamiento de llamada al sistema obtener_id_pr.
  */
@@ -542,30 +1700,77 @@ int sis_obtener_id(){return p_proc_actual->id;}
 
 /* 
  * Funciones auxiliares para bloquear procesos
- * - tipo = {BLOQUEO_DORMIR, BLOQUEO_MUTEX}
+ * - tipo = {BLOQUEO_DORMIR, BLOQUEO_MUTEX, BLOQUEO_RR, BLOQUEO_TERMINAL,
+ *   BLOQUEO_MUTEX_LIBRE}
+ * - En BLOQUEO_MUTEX el mutex en cuya cola se espera va en mutex_espera.
  */
 
 void bloquear_proceso(BCP * proceso , int tipo)
 {
 	
 	proceso->estado=BLOQUEADO;									// cambiamos estado a bloqueado
-	eliminar_primero(&lista_listos);							// eliminamos el primero de la lista listos
+	eliminar_listo(proceso);									// lo sacamos de los listos
+
+	registrar_evento(EV_BLOQUEO, proceso->id, tipo, 0);
+
+	if (tipo == BLOQUEO_RR)										// expulsado por el planificador
+	{
+		proceso->estadisticas.cambios_involuntarios++;
+		pagina.expulsiones++;
+	}
+	else
+		proceso->estadisticas.cambios_voluntarios++;
 
 	switch(tipo)
 	{
 		case BLOQUEO_DORMIR:
-			insertar_ultimo(&lista_bloqueados_dormir, proceso);					// insertar en bloqueados_dormir.
+#if PLANIFICACION == PLANIF_MLFQ
+			promocionar_proceso(proceso);						// proceso interactivo: sube de nivel.
+#endif
+			insertar_ultimo(&rueda_dormir[proceso->despertar_en & (TAM_RUEDA-1)], proceso);	// insertar en su ranura de la rueda.
 			break;
 		case BLOQUEO_MUTEX:
-			insertar_ultimo(&lista_bloqueados_mutex_libre, proceso);			// insertar en bloqueados_mutex.
+			insertar_ultimo(&proceso->mutex_espera->procesos_bloqueados, proceso);	// insertar en la cola del mutex.
+			break;
+		case BLOQUEO_MUTEX_LIBRE:
+			insertar_ultimo(&lista_bloqueados_mutex_libre, proceso);			// insertar en bloqueados_mutex_libre.
 			break;
 		case BLOQUEO_RR:
 			proceso->estado = LISTO;							// cambiamos estado a listo
-			insertar_ultimo(&lista_listos, proceso);			// insertamos al final de la cola de listos.
+			if (proceso->tick_round_robin == 0)					// ha agotado su rodaja
+			{
+#if PLANIFICACION == PLANIF_MLFQ
+				if (proceso->prioridad < NUM_PRIORIDADES-1)
+					proceso->prioridad++;						// baja de nivel.
+#endif
+				proceso->tick_round_robin = TICKS_RODAJA(proceso->prioridad);
+			}
+			insertar_listo(proceso);							// insertamos al final de la cola de listos.
 			break;
 		case BLOQUEO_TERMINAL:
+#if PLANIFICACION == PLANIF_MLFQ
+			promocionar_proceso(proceso);						// proceso interactivo: sube de nivel.
+#endif
 			insertar_ultimo(&lista_bloqueados_terminal, proceso);
 			break;
+		case BLOQUEO_HIJO:
+			insertar_ultimo(&proceso->esperando_hijo, proceso);	// insertar en su cola de espera de hijos.
+			break;
+		case BLOQUEO_SEMAFORO:
+			insertar_ultimo(&proceso->sem_espera->procesos_bloqueados, proceso);	// insertar en la cola del semaforo.
+			break;
+		case BLOQUEO_CONDICION:
+			insertar_ultimo(&proceso->cond_espera->procesos_bloqueados, proceso);	// insertar en la cola de la condicion.
+			break;
+		case BLOQUEO_LECTURA:
+			insertar_ultimo(&proceso->le_espera->lectores_bloqueados, proceso);	// insertar en la cola de lectores.
+			break;
+		case BLOQUEO_ESCRITURA:
+			insertar_ultimo(&proceso->le_espera->escritores_bloqueados, proceso);	// insertar en la cola de escritores.
+			break;
+		case BLOQUEO_BARRERA:
+			insertar_ultimo(&proceso->barrera_espera->procesos_bloqueados, proceso);	// insertar en la cola de la barrera.
+			break;
 		default:
 			break;
 	}
@@ -575,28 +1780,70 @@ void bloquear_proceso(BCP * proceso , int tipo)
 
 void desbloquear_proceso(BCP * proceso, int tipo)
 {
+	registrar_evento(EV_DESPERTAR, proceso->id, tipo, 0);
 	
 	switch(tipo)
 	{
 		case BLOQUEO_DORMIR:
-			eliminar_elem(&lista_bloqueados_dormir, proceso);		// sacamos de la lista de bloqueados_dorir.
-			break;
+			break;												// avanzar_rueda ya lo ha sacado de su ranura.
 		case BLOQUEO_MUTEX:
-			eliminar_elem(&lista_bloqueados_mutex_libre, proceso);	// sacamos de la lista de bloqueados_mutex.
+			eliminar_elem(&proceso->mutex_espera->procesos_bloqueados, proceso);	// sacamos de la cola del mutex.
+			proceso->mutex_espera = NULL;
+			break;
+		case BLOQUEO_MUTEX_LIBRE:
+			eliminar_elem(&lista_bloqueados_mutex_libre, proceso);	// sacamos de la lista de bloqueados_mutex_libre.
 			break;
 		case BLOQUEO_TERMINAL:	
 			eliminar_elem(&lista_bloqueados_terminal, proceso);		//sacasmo de la lista bloqueados_terminal.
 			break;
+		case BLOQUEO_HIJO:
+			eliminar_elem(&proceso->esperando_hijo, proceso);		// sacamos de su cola de espera de hijos.
+			break;
+		case BLOQUEO_SEMAFORO:
+			eliminar_elem(&proceso->sem_espera->procesos_bloqueados, proceso);	// sacamos de la cola del semaforo.
+			proceso->sem_espera = NULL;
+			break;
+		case BLOQUEO_CONDICION:
+			eliminar_elem(&proceso->cond_espera->procesos_bloqueados, proceso);	// sacamos de la cola de la condicion.
+			proceso->cond_espera = NULL;
+			break;
+		case BLOQUEO_ESCRITURA:
+			eliminar_elem(&proceso->le_espera->escritores_bloqueados, proceso);	// sacamos de la cola de escritores.
+			proceso->le_espera = NULL;
+			break;
 		default:
 			break;
 	}
 	
-	insertar_ultimo(&lista_listos, proceso);					// añadimos a listos.
+	insertar_listo(proceso);									// añadimos a listos.
 	proceso->estado=LISTO;										// cambiamos estado a listo.
+#if PLANIFICACION == PLANIF_PRIO
+	expulsar_si_prioritario();									// si es mas prioritario que el actual.
+#endif
 	
 	return;
 }
 
+/*
+ * Desbloquea a la vez a todos los procesos de una lista que el llamante
+ * ya ha separado de su cola de espera: se pasan juntos a listos con
+ * insertar_listos en lugar de uno a uno con desbloquear_proceso.
+ */
+void desbloquear_grupo(lista_BCPs *grupo, int tipo)
+{
+	BCP * proc;
+
+	for (proc = grupo->primero; proc != NULL; proc = proc->siguiente)
+	{
+		registrar_evento(EV_DESPERTAR, proc->id, tipo, 0);
+		proc->estado = LISTO;
+	}
+	insertar_listos(grupo);
+#if PLANIFICACION == PLANIF_PRIO
+	expulsar_si_prioritario();
+#endif
+}
+
 void imprimir_lista(lista_BCPs lista)
 {
 	BCP * BCPptr_recorredor = lista.primero;
@@ -610,7 +1857,34 @@ void imprimir_lista(lista_BCPs lista)
 }
 
 /*
- * Tratamiento de llamada al sistema dormir.
+ * Muestra el conjunto de procesos listos
+ */
+void imprimir_listos()
+{
+#if COLAS_PRIORIDAD
+	int i;
+
+	for (i=0; i<NUM_PRIORIDADES; i++)
+		if (colas_listos[i].primero!=NULL)
+		{
+			printk("-> Prioridad %d ", i);
+			imprimir_lista(colas_listos[i]);
+		}
+#elif PLANIFICACION == PLANIF_CFS
+	int i;
+
+	printk("-> Monticulo: {");
+	for (i=0; i<num_listos; i++)
+		printk(" Proceso:(%d) vruntime %lu ", monticulo_listos[i]->id,
+			monticulo_listos[i]->vruntime);
+	printk("}\n");
+#else
+	imprimir_lista(lista_listos);
+#endif
+}
+
+/*
+ * Tratamiento de llamada al sistema dormir.
  */
 int sis_dormir()
 {
@@ -622,7 +1896,9 @@ int sis_dormir()
 
 	BCP * p_proc_anterior;
 	p_proc_anterior=p_proc_actual;
-	p_proc_anterior->despertar_en = (long)segundos*TICK;
+	p_proc_anterior->despertar_en = ticks_sistema + (unsigned long)segundos*TICK;
+	if (segundos == 0)
+		p_proc_anterior->despertar_en++;						// como minimo hasta el siguiente tick.
 	
 	bloquear_proceso(p_proc_actual, BLOQUEO_DORMIR);				// llamamos a bloquear proceso.
 
@@ -636,13 +1912,161 @@ int sis_dormir()
 	return 0;
 }
 
+/*
+ * Tratamiento de llamada al sistema obtener_ticks. Devuelve los ticks
+ * de reloj transcurridos desde el arranque.
+ */
+int sis_obtener_ticks(){return (int)ticks_sistema;}
+
+/*
+ * Tratamiento de llamada al sistema obtener_pagina. Deja la direccion
+ * de la pagina de datos del kernel compartida con los procesos en la
+ * variable cuya direccion recibe en el registro 1.
+ */
+int sis_obtener_pagina()
+{
+	pagina_kernel **dir = (pagina_kernel **)leer_registro(1);
+
+	if (dir == NULL)
+		return -1;
+	*dir = &pagina;
+	return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema obtener_estadisticas. Copia las
+ * estadisticas de uso de UCP del proceso cuyo id recibe en el registro 1
+ * en la estructura cuya direccion recibe en el registro 2.
+ */
+int sis_obtener_estadisticas()
+{
+	int id = (int)leer_registro(1);
+	estadisticas_proceso *est = (estadisticas_proceso *)leer_registro(2);
+	BCP * proc;
+
+	if (est == NULL || (proc = buscar_BCP(id)) == NULL)
+		return -1;
+
+	*est = proc->estadisticas;
+	est->estado = (proc == p_proc_actual) ? EJECUCION : proc->estado;
+	return 0;
+}
+
+/*
+ * Tratamiento de llamada al sistema volcar_llamadas. Copia en el vector
+ * que recibe en el registro 1 las estadisticas de hasta tantas llamadas
+ * como indica el registro 2, por orden de numero, y las pone a cero si el
+ * registro 3 no es 0. Devuelve el numero de llamadas existentes.
+ */
+int sis_volcar_llamadas()
+{
+	estadisticas_llamada *destino = (estadisticas_llamada *)leer_registro(1);
+	int max = (int)leer_registro(2);
+	int reiniciar = (int)leer_registro(3);
+
+	if (destino == NULL || max < 0)
+		return -1;
+	if (max > NSERVICIOS)
+		max = NSERVICIOS;
+
+	memcpy(destino, estadisticas_llamadas, max*sizeof(estadisticas_llamada));
+	if (reiniciar)
+		memset(estadisticas_llamadas, 0, sizeof(estadisticas_llamadas));
+	return NSERVICIOS;
+}
+
+/*
+ * Tratamiento de llamada al sistema leer_traza. Copia en el vector que
+ * recibe en el registro 1 hasta tantos eventos como indica el registro 2,
+ * empezando por el mas antiguo no leido. Si el buffer ha dado la vuelta
+ * los eventos sobrescritos se pierden, igual que uno que se sobrescribe
+ * mientras se copia: la secuencia se lee antes y despues de la copia y,
+ * si no es la esperada en ambas, el evento se descarta. Devuelve el
+ * numero copiado.
+ */
+int sis_leer_traza()
+{
+	evento_traza *destino = (evento_traza *)leer_registro(1);
+	int max = (int)leer_registro(2);
+	unsigned long escritos = traza_escritos;
+	volatile evento_traza *origen;
+	unsigned long secuencia;
+	evento_traza ev;
+	int n = 0;
+
+	if (destino == NULL || max < 0)
+		return -1;
+
+	if (escritos - traza_leidos > TAM_TRAZA)
+		traza_leidos = escritos - TAM_TRAZA;
+
+	for ( ; n < max && traza_leidos != escritos; traza_leidos++)
+	{
+		origen = &traza[traza_leidos & (TAM_TRAZA-1)];
+		secuencia = origen->secuencia;
+		__sync_synchronize();
+		ev.tick = origen->tick;
+		ev.tipo = origen->tipo;
+		ev.id = origen->id;
+		ev.arg = origen->arg;
+		ev.valor = origen->valor;
+		__sync_synchronize();
+		if (secuencia != traza_leidos + 1 || origen->secuencia != secuencia)
+			continue;				/* sobrescrito antes o durante la copia */
+		ev.secuencia = secuencia;
+		destino[n++] = ev;
+	}
+	return n;
+}
+
+/*
+ * Tratamiento de llamada al sistema listar_procesos. Copia en el vector
+ * que recibe en el registro 1 los ids de hasta tantos procesos existentes
+ * como indica el registro 2. Devuelve el numero de procesos existentes,
+ * que puede ser mayor que el de copiados.
+ */
+int sis_listar_procesos()
+{
+	int *ids = (int *)leer_registro(1);
+	int max = (int)leer_registro(2);
+	int i, n = 0;
+
+	if (ids == NULL || max < 0)
+		return -1;
+
+	for (i = 0; i < tam_tabla_procs; i++)
+		if (tabla_procs[i]->estado != NO_USADA)
+		{
+			if (n < max)
+				ids[n] = tabla_procs[i]->id;
+			n++;
+		}
+	return n;
+}
+
 /* Funciones auxiliares para mutex */
 
 static void iniciar_tabla_mutex()
 {
 	int i;
-	for(i = 0; i < NUM_MUT; i++)
+
+	num_mut = leer_parametro_arranque("NUM_MUT", NUM_MUT);
+
+	/* el hash tiene al menos tantas cubetas como mutex (potencia de 2) */
+	for(tam_hash_mutex = 1; tam_hash_mutex < (unsigned int)num_mut; tam_hash_mutex <<= 1);
+
+	tabla_mutex = malloc(num_mut * sizeof(mutex));
+	hash_mutex = calloc(tam_hash_mutex, sizeof(mutex_ptr));
+	if (tabla_mutex == NULL || hash_mutex == NULL)
+		panico("no hay memoria para la tabla de mutex");
+
+	mutex_libres = NULL;
+	for(i = num_mut - 1; i >= 0; i--)
+	{
 		tabla_mutex[i].estado = LIBRE; /* indica que el mutex esta libre */
+		tabla_mutex[i].siguiente = mutex_libres;
+		mutex_libres = &tabla_mutex[i];
+	}
 }
 
 static int buscar_descriptor_libre()
@@ -657,40 +2081,73 @@ static int buscar_descriptor_libre()
 	return -1; /* no hay descriptor libre */
 }
 
-static int buscar_nombre_mutex(char *nombre_mutex)
+/*
+ * Funcion hash sobre el nombre de un mutex
+ */
+static unsigned int hash_nombre_mutex(char *nombre_mutex)
 {
-	int i;
-	for(i = 0; i < NUM_MUT; i++)
-	{
-		if(tabla_mutex[i].estado == OCUPADO && strcmp(tabla_mutex[i].nombre, nombre_mutex) == 0)
-			return i;	/* el nombre existe y devuelve su posicion en la tabla de mutex */
-	}
-	
-	return -1; /* el nombre no existe */
+	return hash_nombre(nombre_mutex) & (tam_hash_mutex - 1);
 }
 
-static int buscar_mutex_libre()
+static mutex_ptr buscar_nombre_mutex(char *nombre_mutex)
 {
-	int i;
-	for(i = 0; i < NUM_MUT; i++)
+	mutex_ptr m;
+
+	for(m = hash_mutex[hash_nombre_mutex(nombre_mutex)]; m != NULL; m = m->siguiente)
 	{
-		if(tabla_mutex[i].estado == LIBRE)
-			return i;	/* el mutex esta libre y devuelve su posicion en la tabla de mutex */
+		if(strcmp(m->nombre, nombre_mutex) == 0)
+			return m;	/* el nombre existe */
 	}
 	
-	return -1; /* no hay mutex libre */
+	return NULL; /* el nombre no existe */
 }
 
-void asignar_mutex(char* nombre, int tipo, int in_descr, int in_t_mutex)
+/*
+ * Saca una entrada de la lista de libres, la inicia y la da de alta en
+ * el hash de nombres. Devuelve NULL si no quedan entradas libres.
+ */
+static mutex_ptr asignar_mutex(char *nombre, int tipo)
 {
-	tabla_mutex[in_descr].nombre = nombre; 			// se copia el nombre al mutex
-	tabla_mutex[in_descr].tipo = tipo; 				// se asigna el tipo
-	
-	tabla_mutex[in_descr].estado = OCUPADO; 		// se cambia el estado a OCUPADO
-	tabla_mutex[in_descr].num_bloqueos = 0;
-	tabla_mutex[in_descr].num_procesos_bloqueados = 0;
-	
-	p_proc_actual->descriptores_mutex[in_descr] = &tabla_mutex[in_t_mutex]; // el descr apunta al mutex libre en la tabla
+	mutex_ptr m = mutex_libres;
+	unsigned int cubeta;
+
+	if(m == NULL)
+		return NULL;
+	mutex_libres = m->siguiente;
+
+	strcpy(m->nombre, nombre);	// se copia el nombre al mutex
+	m->cerrojo.tipo = tipo;		// se asigna el tipo
+	m->cerrojo.palabra = 0;		// libre
+	m->cerrojo.cuenta = 0;
+	m->estado = OCUPADO;		// se cambia el estado a OCUPADO
+	m->procesos_bloqueados.primero = NULL;
+	m->procesos_bloqueados.ultimo = NULL;
+	m->num_procesos_bloqueados = 0;
+	m->num_abiertos = 0;
+
+	cubeta = hash_nombre_mutex(m->nombre);
+	m->siguiente = hash_mutex[cubeta];
+	hash_mutex[cubeta] = m;
+
+	return m;
+}
+
+/*
+ * Da de baja un mutex del hash de nombres y devuelve su entrada a la
+ * lista de libres.
+ */
+static void destruir_mutex(mutex_ptr m)
+{
+	mutex_ptr *enlace = &hash_mutex[hash_nombre_mutex(m->nombre)];
+
+	while(*enlace != m)
+		enlace = &(*enlace)->siguiente;
+	*enlace = m->siguiente;
+
+	m->nombre[0] = '\0';
+	m->estado = LIBRE;
+	m->siguiente = mutex_libres;
+	mutex_libres = m;
 }
 
 /*
@@ -705,61 +2162,57 @@ int sis_crear_mutex()
 
 	if(strlen(nombre) > MAX_NOM_MUT)
 	{
-		printk("(SIS_CREAR_MUTEX) Error: Nombre de mutex demasiado largo\n");
+		PRINTK_ERROR("(SIS_CREAR_MUTEX) Error: Nombre de mutex demasiado largo\n");
 		return -1;
 	}
 
-	if(buscar_nombre_mutex(nombre) >= 0)
+	if(buscar_nombre_mutex(nombre) != NULL)
 	{
-		printk("(SIS_CREAR_MUTEX) Error: Nombre de mutex ya existente\n");
+		PRINTK_ERROR("(SIS_CREAR_MUTEX) Error: Nombre de mutex ya existente\n");
 		return -2;
 	}
 
 	int descr_mutex_libre = buscar_descriptor_libre();
 	
-	printf("encontro descriptor %d\n", descr_mutex_libre);
+	PRINTK_DETALLE("encontro descriptor %d\n", descr_mutex_libre);
 	
 	if(descr_mutex_libre < 0)
 	{
-		printk("(SIS_CREAR_MUTEX) Error: No hay descriptores de mutex libres\n");
+		PRINTK_ERROR("(SIS_CREAR_MUTEX) Error: No hay descriptores de mutex libres\n");
 		return -3;
 	}
 	else
-		printk("(SIS_CREAR_MUTEX) Devolviendo descriptor numero %d\n", descr_mutex_libre);
+		PRINTK_DETALLE("(SIS_CREAR_MUTEX) Devolviendo descriptor numero %d\n", descr_mutex_libre);
 
 
-	printk("KERNEL: Busca mutex libre\n");
+	PRINTK_DETALLE("KERNEL: Busca mutex libre\n");
 	
-	int pos_mutex_libre = buscar_mutex_libre();
+	mutex_ptr m;
 	
-	if(pos_mutex_libre < 0)
+	while((m = asignar_mutex(nombre, tipo)) == NULL)
 	{
-		printk("(SIS_CREAR_MUTEX) No hay mutex libre, bloqueando proceso\n");
+		PRINTK_EVENTO("(SIS_CREAR_MUTEX) No hay mutex libre, bloqueando proceso\n");
 		
 		// bloquear a la espera de que quede alguno libre
 		BCP * proc_a_bloquear=p_proc_actual;
 		int nivel_int = fijar_nivel_int(3);
 					
-		bloquear_proceso(proc_a_bloquear, BLOQUEO_MUTEX);
+		bloquear_proceso(proc_a_bloquear, BLOQUEO_MUTEX_LIBRE);
 
 		p_proc_actual=planificador();
 		fijar_nivel_int(nivel_int);
 		
 		cambio_contexto(&(proc_a_bloquear->contexto_regs), 
 						&(p_proc_actual->contexto_regs));
+
+		// Mientras esperaba otro proceso ha podido crear uno con ese nombre.
+		if(buscar_nombre_mutex(nombre) != NULL)
+			return -2;
 	}
-	else
-	{
-		tabla_mutex[pos_mutex_libre].nombre = nombre; // se copia el nombre al mutex
-		tabla_mutex[pos_mutex_libre].tipo = tipo; // se asigna el tipo
-		tabla_mutex[pos_mutex_libre].estado = OCUPADO; // se cambia el estado a OCUPADO
-		tabla_mutex[pos_mutex_libre].num_bloqueos = 0;
-		//jose mira esto
-		tabla_mutex[pos_mutex_libre].in_insertar = 0;
-		tabla_mutex[pos_mutex_libre].in_borrar = 0;
-		tabla_mutex[pos_mutex_libre].num_procesos_bloqueados = 0;
-		p_proc_actual->descriptores_mutex[descr_mutex_libre] = &tabla_mutex[pos_mutex_libre]; // el descr apunta al mutex libre en la tabla
-	}			
+
+	m->num_abiertos = 1;
+	p_proc_actual->descriptores_mutex[descr_mutex_libre] = m; // el descr apunta al mutex asignado en la tabla
+	p_proc_actual->datos_usuario.cerrojos[descr_mutex_libre] = &m->cerrojo;
 	
 	return descr_mutex_libre;
 }
@@ -778,11 +2231,13 @@ int sis_abrir_mutex()
 		return -1;
 
 	// Compruebo si hay mutex con el mismo nombre
-	int posicion_tabla = buscar_nombre_mutex(nombre);
-	if(posicion_tabla == -1)
+	mutex_ptr m = buscar_nombre_mutex(nombre);
+	if(m == NULL)
 		return -1;
 
-	p_proc_actual->descriptores_mutex[descriptor] = &tabla_mutex[posicion_tabla];
+	m->num_abiertos++;
+	p_proc_actual->descriptores_mutex[descriptor] = m;
+	p_proc_actual->datos_usuario.cerrojos[descriptor] = &m->cerrojo;
 	
 	return descriptor;
 }
@@ -793,7 +2248,7 @@ int sis_abrir_mutex()
 int sis_cerrar_mutex()
 {
 	unsigned int descriptor = (unsigned int) leer_registro(1);
-	if(p_proc_actual->descriptores_mutex[descriptor] == NULL)
+	if(descriptor >= NUM_MUT_PROC || p_proc_actual->descriptores_mutex[descriptor] == NULL)
 		return -1;
 
 	liberar_mutex(descriptor);
@@ -806,49 +2261,138 @@ int sis_cerrar_mutex()
  */
 void liberar_mutex (int descriptor)
 {
-	p_proc_actual->descriptores_mutex[descriptor]->nombre = NULL;
-	p_proc_actual->descriptores_mutex[descriptor]->estado = LIBRE;
+	mutex_ptr m = p_proc_actual->descriptores_mutex[descriptor];
+	int nivel_int;
+
+	// Si lo poseia, se cede al siguiente de su cola.
+	if (POSEEDOR_MUTEX(m) == p_proc_actual->id)
+		ceder_mutex(m);
+
 	p_proc_actual->descriptores_mutex[descriptor] = NULL;
+	p_proc_actual->datos_usuario.cerrojos[descriptor] = NULL;
+
+	// Mientras otros procesos lo tengan abierto la entrada no puede reutilizarse.
+	if (--m->num_abiertos > 0)
+		return;
+
+	destruir_mutex(m);
+
+	// Despierta a un proceso que esperaba en crear_mutex por una entrada libre.
+	if (lista_bloqueados_mutex_libre.primero != NULL)
+	{
+		nivel_int = fijar_nivel_int(3);
+		desbloquear_proceso(lista_bloqueados_mutex_libre.primero, BLOQUEO_MUTEX_LIBRE);
+		fijar_nivel_int(nivel_int);
+	}
+}
+
+#if PLANIFICACION == PLANIF_PRIO
+/*
+ * Herencia de prioridad: la prioridad efectiva de un proceso es la mas
+ * alta entre la fijada por el y la de los procesos bloqueados en los
+ * mutex que posee, que solo puede haber abierto con sus descriptores.
+ * Devuelve la que le corresponde a proc.
+ */
+static int prioridad_heredada(BCP * proc)
+{
+	BCP * BCPptr_recorredor;
+	mutex_ptr m;
+	int i, prio = proc->prioridad_base;
+
+	for (i = 0; i < NUM_MUT_PROC; i++)
+	{
+		m = proc->descriptores_mutex[i];
+		if (m == NULL || POSEEDOR_MUTEX(m) != proc->id)
+			continue;
+		for (BCPptr_recorredor = m->procesos_bloqueados.primero; BCPptr_recorredor != NULL;
+				BCPptr_recorredor = BCPptr_recorredor->siguiente)
+			if (BCPptr_recorredor->prioridad < prio)
+				prio = BCPptr_recorredor->prioridad;
+	}
+	return prio;
+}
+
+/*
+ * Recalcula la prioridad efectiva de proc y, si cambia, lo recoloca en
+ * los listos y repite con el poseedor del mutex en el que espera, de modo
+ * que la herencia se propaga por las cadenas de mutex. Se llama con las
+ * interrupciones inhibidas; admite proc NULL.
+ */
+static void recalcular_prioridad(BCP * proc)
+{
+	int prio;
+
+	while (proc != NULL && (prio = prioridad_heredada(proc)) != proc->prioridad)
+	{
+		if (proc->estado == LISTO)
+		{
+			eliminar_listo(proc);
+			proc->prioridad = prio;
+			insertar_listo(proc);
+		}
+		else
+			proc->prioridad = prio;
+
+		if (proc->estado == BLOQUEADO && proc->mutex_espera != NULL)
+			proc = buscar_BCP(POSEEDOR_MUTEX(proc->mutex_espera));
+		else
+			proc = NULL;
+	}
 }
+#endif
 
 /*
  * LLamada al sistema lock mutex.
+ *
+ * La biblioteca adquiere directamente con una operacion atomica los mutex
+ * libres y los que ya posee, por lo que solo se llega aqui cuando hay
+ * contencion (o el descriptor es erroneo). Como entre el intento en modo
+ * usuario y la llamada el mutex ha podido quedar libre, se repiten aqui
+ * las mismas comprobaciones.
  */
 int sis_lock_mutex()
 {
 	unsigned int descriptor = (unsigned int)leer_registro(1);
+	mutex_ptr m;
+	int yo;
 	
-	if (p_proc_actual->descriptores_mutex[descriptor] == NULL)
+	if (descriptor >= NUM_MUT_PROC || p_proc_actual->descriptores_mutex[descriptor] == NULL)
 		return -1; 
 	
-	// Numero de veces que se ha bloqueado llamando a lock
+	m = p_proc_actual->descriptores_mutex[descriptor];
+	yo = p_proc_actual->id + 1;
 
-	if (p_proc_actual->descriptores_mutex[descriptor]->num_bloqueos == 0)
+	if (__sync_bool_compare_and_swap(&m->cerrojo.palabra, 0, yo))
 	{
-		p_proc_actual->descriptores_mutex[descriptor]->id_proc_poseedor = p_proc_actual->id;
-		p_proc_actual->descriptores_mutex[descriptor]->num_bloqueos++;
+		m->cerrojo.cuenta = 1;
 	}
 	else
 	{
-		if (p_proc_actual->id == p_proc_actual->descriptores_mutex[descriptor]->id_proc_poseedor)
+		if (POSEEDOR_MUTEX(m) == p_proc_actual->id)
 		{
-			if (p_proc_actual->descriptores_mutex[descriptor]->tipo == RECURSIVO)
-				p_proc_actual->descriptores_mutex[descriptor]->num_bloqueos++;
+			if (m->cerrojo.tipo == RECURSIVO)
+				m->cerrojo.cuenta++;
 			else
 				return -1; // hubo fail.
 		}
 		else
 		{
-			p_proc_actual->descriptores_mutex[descriptor]->num_procesos_bloqueados++;
-
-			//int nbloqueos = p_proc_actual->descriptores_mutex[descriptor]->num_procesos_bloqueados;
-			//jose mira esto
-			p_proc_actual->descriptores_mutex[descriptor]->procesos_bloqueados[p_proc_actual->descriptores_mutex[descriptor]->in_insertar] = p_proc_actual->id;
-			p_proc_actual->descriptores_mutex[descriptor]->in_insertar++;
+			/*
+			 * Se marca que hay esperas, para que el poseedor no lo libere
+			 * en modo usuario, y se encola al final de la cola del mutex.
+			 * Cuando el poseedor lo libere se le cedera directamente (ver
+			 * ceder_mutex), por lo que al despertar ya es su poseedor.
+			 */
+			__sync_fetch_and_or(&m->cerrojo.palabra, CERROJO_ESPERAS);
+			m->num_procesos_bloqueados++;
 
 			int nivel_int=fijar_nivel_int(3);
 
+			p_proc_actual->mutex_espera = m;
 			bloquear_proceso(p_proc_actual, BLOQUEO_MUTEX);
+#if PLANIFICACION == PLANIF_PRIO
+			recalcular_prioridad(buscar_BCP(POSEEDOR_MUTEX(m)));	// el poseedor hereda su prioridad.
+#endif
 			
 			BCP * p_proc_anterior;
 			p_proc_anterior=p_proc_actual;
@@ -864,36 +2408,67 @@ int sis_lock_mutex()
 	return 0;
 }
 
+/*
+ * Libera del todo un mutex poseido por el proceso actual. Si hay procesos
+ * en su cola se le cede al primero (orden FIFO), que pasa a poseerlo. Con
+ * PLANIF_PRIO se le cede al mas prioritario y el proceso actual pierde la
+ * prioridad que hubiera heredado por el.
+ */
+void ceder_mutex(mutex_ptr m)
+{
+	BCP * BCPptr_despertar = m->procesos_bloqueados.primero;
+	int nivel_int;
+
+	if (BCPptr_despertar == NULL)
+	{
+		m->cerrojo.cuenta = 0;
+		m->cerrojo.palabra = 0;
+		return;
+	}
+#if PLANIFICACION == PLANIF_PRIO
+	BCP * BCPptr_recorredor;
+
+	for (BCPptr_recorredor = BCPptr_despertar->siguiente; BCPptr_recorredor != NULL;
+			BCPptr_recorredor = BCPptr_recorredor->siguiente)
+		if (BCPptr_recorredor->prioridad < BCPptr_despertar->prioridad)
+			BCPptr_despertar = BCPptr_recorredor;
+#endif
+
+	m->num_procesos_bloqueados--;
+	m->cerrojo.cuenta = 1;
+	m->cerrojo.palabra = (BCPptr_despertar->id + 1) |
+		(m->num_procesos_bloqueados > 0 ? CERROJO_ESPERAS : 0);
+
+	nivel_int = fijar_nivel_int(3);
+	desbloquear_proceso(BCPptr_despertar, BLOQUEO_MUTEX);
+#if PLANIFICACION == PLANIF_PRIO
+	recalcular_prioridad(BCPptr_despertar);		// hereda de los que siguen esperando.
+	recalcular_prioridad(p_proc_actual);		// deshace la herencia.
+	expulsar_si_prioritario();
+#endif
+	fijar_nivel_int(nivel_int);
+}
+
 /*
  * Llamada auxiliar de sis_unlock_mutex()
  */
 int aux_unlock_mutex(int descriptor)
 {
-	if (p_proc_actual->descriptores_mutex[descriptor] == NULL)
+	mutex_ptr m;
+
+	if (descriptor < 0 || descriptor >= NUM_MUT_PROC || p_proc_actual->descriptores_mutex[descriptor] == NULL)
 		return -1; 
 
-	if(p_proc_actual->id != p_proc_actual->descriptores_mutex[descriptor]->id_proc_poseedor)
+	m = p_proc_actual->descriptores_mutex[descriptor];
+
+	if(POSEEDOR_MUTEX(m) != p_proc_actual->id)
 		return 0;
 	
-	p_proc_actual->descriptores_mutex[descriptor]->num_bloqueos--;
+	m->cerrojo.cuenta--;
 	
-	if(p_proc_actual->descriptores_mutex[descriptor]->num_bloqueos <= 0)
-	{
-		//jose mira esto:
-		int pid_desbloqueo = p_proc_actual->descriptores_mutex[descriptor]->procesos_bloqueados[p_proc_actual->descriptores_mutex[descriptor]->in_borrar];
-		p_proc_actual->descriptores_mutex[descriptor]->in_borrar ++;
+	if(m->cerrojo.cuenta <= 0)
+		ceder_mutex(m);
 
-		BCPptr BCPptr_recorredor = lista_bloqueados_mutex_libre.primero;
-		while (BCPptr_recorredor != NULL)
-		{
-			if (BCPptr_recorredor->id == pid_desbloqueo)
-			{
-				desbloquear_proceso(BCPptr_recorredor, BLOQUEO_MUTEX);
-				break;
-			}	
-			BCPptr_recorredor = BCPptr_recorredor -> siguiente;
-		}
-	}
 	return 0;
 }
 
@@ -908,6 +2483,1078 @@ int sis_unlock_mutex()
 	return aux_unlock_mutex(descriptor);
 }
 
+/*
+ * Tratamiento de llamada al sistema fijar_prioridad. Fija la prioridad
+ * del proceso actual en el nivel que recibe en el registro 1 (0 es el mas
+ * prioritario) y devuelve la que tenia fijada. Mientras posea un mutex
+ * por el que espere otro mas prioritario ejecuta con la de este. Devuelve
+ * -1 si el nivel no es valido o la politica no es PLANIF_PRIO.
+ */
+int sis_fijar_prioridad()
+{
+#if PLANIFICACION == PLANIF_PRIO
+	int prio = (int)leer_registro(1);
+	int anterior, nivel_int;
+
+	if (prio < 0 || prio >= NUM_PRIORIDADES)
+		return -1;
+
+	nivel_int = fijar_nivel_int(3);
+	anterior = p_proc_actual->prioridad_base;
+	p_proc_actual->prioridad_base = prio;
+	recalcular_prioridad(p_proc_actual);
+	expulsar_si_prioritario();
+	fijar_nivel_int(nivel_int);
+	return anterior;
+#else
+	return -1;
+#endif
+}
+
+/*
+ *
+ * Funciones relacionadas con los semaforos
+ *	sis_crear_sem sis_abrir_sem sis_esperar_sem sis_senalar_sem sis_cerrar_sem
+ *
+ * Un semaforo contador se organiza como los mutex: entradas de tabla_sem
+ * con nombre, indexadas por un hash, y referenciadas desde los
+ * descriptores de los procesos que lo han abierto. senalar_sem cede la
+ * unidad directamente al primero de la cola, que al despertar ya la tiene.
+ *
+ */
+
+static void iniciar_tabla_sem()
+{
+	int i;
+
+	num_sem = leer_parametro_arranque("NUM_SEM", NUM_SEM);
+
+	for(tam_hash_sem = 1; tam_hash_sem < (unsigned int)num_sem; tam_hash_sem <<= 1);
+
+	tabla_sem = malloc(num_sem * sizeof(semaforo));
+	hash_sem = calloc(tam_hash_sem, sizeof(semaforo_ptr));
+	if (tabla_sem == NULL || hash_sem == NULL)
+		panico("no hay memoria para la tabla de semaforos");
+
+	sem_libres = NULL;
+	for(i = num_sem - 1; i >= 0; i--)
+	{
+		tabla_sem[i].estado = LIBRE;
+		tabla_sem[i].siguiente = sem_libres;
+		sem_libres = &tabla_sem[i];
+	}
+}
+
+static int buscar_descriptor_sem_libre()
+{
+	int i;
+
+	for(i = 0; i < NUM_SEM_PROC; i++)
+		if(p_proc_actual->descriptores_sem[i] == NULL)
+			return i;
+	return -1;
+}
+
+static semaforo_ptr buscar_nombre_sem(char *nombre)
+{
+	semaforo_ptr s;
+
+	for(s = hash_sem[hash_nombre(nombre) & (tam_hash_sem - 1)]; s != NULL; s = s->siguiente)
+		if(strcmp(s->nombre, nombre) == 0)
+			return s;
+	return NULL;
+}
+
+/*
+ * Devuelve el semaforo de un descriptor del proceso actual o NULL si no
+ * es valido
+ */
+static semaforo_ptr semaforo_descriptor(unsigned int descriptor)
+{
+	if (descriptor >= NUM_SEM_PROC)
+		return NULL;
+	return p_proc_actual->descriptores_sem[descriptor];
+}
+
+/*
+ * Llamada al sistema crear_sem. Crea un semaforo con el nombre del
+ * registro 1 y el valor inicial del registro 2 y lo abre. Devuelve su
+ * descriptor, -1 si el nombre es demasiado largo o el valor negativo, -2
+ * si ya existe, -3 si no hay descriptores libres y -4 si no hay entradas
+ * libres en la tabla.
+ */
+int sis_crear_sem()
+{
+	char *nombre = (char *)leer_registro(1);
+	int valor = (int)leer_registro(2);
+	int descriptor;
+	unsigned int cubeta;
+	semaforo_ptr s;
+
+	if (strlen(nombre) > MAX_NOM_SEM || valor < 0)
+		return -1;
+	if (buscar_nombre_sem(nombre) != NULL)
+		return -2;
+	if ((descriptor = buscar_descriptor_sem_libre()) < 0)
+		return -3;
+	if ((s = sem_libres) == NULL)
+		return -4;
+	sem_libres = s->siguiente;
+
+	strcpy(s->nombre, nombre);
+	s->estado = OCUPADO;
+	s->valor = valor;
+	s->procesos_bloqueados.primero = s->procesos_bloqueados.ultimo = NULL;
+	s->num_abiertos = 1;
+
+	cubeta = hash_nombre(nombre) & (tam_hash_sem - 1);
+	s->siguiente = hash_sem[cubeta];
+	hash_sem[cubeta] = s;
+
+	p_proc_actual->descriptores_sem[descriptor] = s;
+	return descriptor;
+}
+
+/*
+ * Llamada al sistema abrir_sem. Devuelve un descriptor del semaforo con
+ * el nombre del registro 1 o -1 si no existe o no hay descriptores libres.
+ */
+int sis_abrir_sem()
+{
+	char *nombre = (char *)leer_registro(1);
+	int descriptor;
+	semaforo_ptr s;
+
+	if ((descriptor = buscar_descriptor_sem_libre()) < 0 ||
+		(s = buscar_nombre_sem(nombre)) == NULL)
+		return -1;
+
+	s->num_abiertos++;
+	p_proc_actual->descriptores_sem[descriptor] = s;
+	return descriptor;
+}
+
+/*
+ * Llamada al sistema esperar_sem. Toma una unidad del semaforo del
+ * descriptor del registro 1, bloqueandose al final de su cola si no hay.
+ */
+int sis_esperar_sem()
+{
+	semaforo_ptr s = semaforo_descriptor((unsigned int)leer_registro(1));
+	BCP * p_proc_anterior;
+	int nivel_int;
+
+	if (s == NULL)
+		return -1;
+
+	if (s->valor > 0)
+	{
+		s->valor--;
+		return 0;
+	}
+
+	nivel_int = fijar_nivel_int(3);
+	p_proc_actual->sem_espera = s;
+	bloquear_proceso(p_proc_actual, BLOQUEO_SEMAFORO);
+	p_proc_anterior = p_proc_actual;
+	p_proc_actual = planificador();
+	fijar_nivel_int(nivel_int);
+	cambio_contexto(&(p_proc_anterior->contexto_regs), &(p_proc_actual->contexto_regs));
+	return 0;	/* senalar_sem le ha cedido la unidad */
+}
+
+/*
+ * Llamada al sistema senalar_sem. Devuelve una unidad al semaforo del
+ * descriptor del registro 1: si hay procesos esperando se la cede al
+ * primero y, si no, incrementa su valor.
+ */
+int sis_senalar_sem()
+{
+	semaforo_ptr s = semaforo_descriptor((unsigned int)leer_registro(1));
+	int nivel_int;
+
+	if (s == NULL)
+		return -1;
+
+	if (s->procesos_bloqueados.primero == NULL)
+	{
+		s->valor++;
+		return 0;
+	}
+
+	nivel_int = fijar_nivel_int(3);
+	desbloquear_proceso(s->procesos_bloqueados.primero, BLOQUEO_SEMAFORO);
+	fijar_nivel_int(nivel_int);
+	return 0;
+}
+
+/*
+ * Funcion auxiliar que cierra un descriptor de semaforo del proceso
+ * actual, liberando la entrada cuando ya no lo tiene abierto nadie
+ */
+void liberar_sem(int descriptor)
+{
+	semaforo_ptr s = p_proc_actual->descriptores_sem[descriptor];
+	semaforo_ptr *enlace;
+
+	p_proc_actual->descriptores_sem[descriptor] = NULL;
+	if (--s->num_abiertos > 0)
+		return;
+
+	enlace = &hash_sem[hash_nombre(s->nombre) & (tam_hash_sem - 1)];
+	while (*enlace != s)
+		enlace = &(*enlace)->siguiente;
+	*enlace = s->siguiente;
+
+	s->nombre[0] = '\0';
+	s->estado = LIBRE;
+	s->siguiente = sem_libres;
+	sem_libres = s;
+}
+
+/*
+ * Llamada al sistema cerrar_sem
+ */
+int sis_cerrar_sem()
+{
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+
+	if (semaforo_descriptor(descriptor) == NULL)
+		return -1;
+	liberar_sem(descriptor);
+	return 0;
+}
+
+/*
+ *
+ * Funciones relacionadas con las variables condicion
+ *	sis_crear_cond sis_abrir_cond sis_esperar_cond sis_senalar_cond
+ *	sis_difundir_cond sis_cerrar_cond
+ *
+ * Se organizan como los semaforos. esperar_cond libera el mutex indicado
+ * y bloquea al proceso en la cola de la condicion sin que nadie pueda
+ * intervenir entre ambas cosas. senalar_cond y difundir_cond no lo
+ * despiertan: lo pasan a la cola del mutex (wait morphing), de modo que
+ * solo ejecuta cuando ceder_mutex se lo entrega y no compite con los demas
+ * despertados por el mutex. Si el mutex esta libre se le da directamente.
+ *
+ */
+
+static void iniciar_tabla_cond()
+{
+	int i;
+
+	num_cond = leer_parametro_arranque("NUM_COND", NUM_COND);
+
+	for(tam_hash_cond = 1; tam_hash_cond < (unsigned int)num_cond; tam_hash_cond <<= 1);
+
+	tabla_cond = malloc(num_cond * sizeof(condicion));
+	hash_cond = calloc(tam_hash_cond, sizeof(condicion_ptr));
+	if (tabla_cond == NULL || hash_cond == NULL)
+		panico("no hay memoria para la tabla de variables condicion");
+
+	cond_libres = NULL;
+	for(i = num_cond - 1; i >= 0; i--)
+	{
+		tabla_cond[i].estado = LIBRE;
+		tabla_cond[i].siguiente = cond_libres;
+		cond_libres = &tabla_cond[i];
+	}
+}
+
+static int buscar_descriptor_cond_libre()
+{
+	int i;
+
+	for(i = 0; i < NUM_COND_PROC; i++)
+		if(p_proc_actual->descriptores_cond[i] == NULL)
+			return i;
+	return -1;
+}
+
+static condicion_ptr buscar_nombre_cond(char *nombre)
+{
+	condicion_ptr c;
+
+	for(c = hash_cond[hash_nombre(nombre) & (tam_hash_cond - 1)]; c != NULL; c = c->siguiente)
+		if(strcmp(c->nombre, nombre) == 0)
+			return c;
+	return NULL;
+}
+
+/*
+ * Devuelve la variable condicion de un descriptor del proceso actual o
+ * NULL si no es valido
+ */
+static condicion_ptr condicion_descriptor(unsigned int descriptor)
+{
+	if (descriptor >= NUM_COND_PROC)
+		return NULL;
+	return p_proc_actual->descriptores_cond[descriptor];
+}
+
+/*
+ * Llamada al sistema crear_cond. Crea una variable condicion con el
+ * nombre del registro 1 y la abre. Devuelve su descriptor, -1 si el
+ * nombre es demasiado largo, -2 si ya existe, -3 si no hay descriptores
+ * libres y -4 si no hay entradas libres en la tabla.
+ */
+int sis_crear_cond()
+{
+	char *nombre = (char *)leer_registro(1);
+	int descriptor;
+	unsigned int cubeta;
+	condicion_ptr c;
+
+	if (strlen(nombre) > MAX_NOM_COND)
+		return -1;
+	if (buscar_nombre_cond(nombre) != NULL)
+		return -2;
+	if ((descriptor = buscar_descriptor_cond_libre()) < 0)
+		return -3;
+	if ((c = cond_libres) == NULL)
+		return -4;
+	cond_libres = c->siguiente;
+
+	strcpy(c->nombre, nombre);
+	c->estado = OCUPADO;
+	c->procesos_bloqueados.primero = c->procesos_bloqueados.ultimo = NULL;
+	c->num_abiertos = 1;
+
+	cubeta = hash_nombre(nombre) & (tam_hash_cond - 1);
+	c->siguiente = hash_cond[cubeta];
+	hash_cond[cubeta] = c;
+
+	p_proc_actual->descriptores_cond[descriptor] = c;
+	return descriptor;
+}
+
+/*
+ * Llamada al sistema abrir_cond. Devuelve un descriptor de la variable
+ * condicion con el nombre del registro 1 o -1 si no existe o no hay
+ * descriptores libres.
+ */
+int sis_abrir_cond()
+{
+	char *nombre = (char *)leer_registro(1);
+	int descriptor;
+	condicion_ptr c;
+
+	if ((descriptor = buscar_descriptor_cond_libre()) < 0 ||
+		(c = buscar_nombre_cond(nombre)) == NULL)
+		return -1;
+
+	c->num_abiertos++;
+	p_proc_actual->descriptores_cond[descriptor] = c;
+	return descriptor;
+}
+
+/*
+ * Llamada al sistema esperar_cond. Recibe en el registro 1 el descriptor
+ * de la condicion y en el 2 el de un mutex que debe poseer el proceso.
+ * Libera del todo el mutex y se bloquea en la condicion; al volver vuelve
+ * a poseerlo con la misma cuenta que tenia. Devuelve -1 si algun
+ * descriptor no es valido o no posee el mutex.
+ */
+int sis_esperar_cond()
+{
+	condicion_ptr c = condicion_descriptor((unsigned int)leer_registro(1));
+	unsigned int descr_mutex = (unsigned int)leer_registro(2);
+	BCP * p_proc_anterior;
+	mutex_ptr m;
+	int cuenta, nivel_int;
+
+	if (c == NULL || descr_mutex >= NUM_MUT_PROC ||
+		(m = p_proc_actual->descriptores_mutex[descr_mutex]) == NULL ||
+		POSEEDOR_MUTEX(m) != p_proc_actual->id)
+		return -1;
+
+	cuenta = m->cerrojo.cuenta;
+
+	nivel_int = fijar_nivel_int(3);
+	ceder_mutex(m);
+	p_proc_actual->cond_espera = c;
+	p_proc_actual->mutex_cond = m;
+	bloquear_proceso(p_proc_actual, BLOQUEO_CONDICION);
+	p_proc_anterior = p_proc_actual;
+	p_proc_actual = planificador();
+	fijar_nivel_int(nivel_int);
+	cambio_contexto(&(p_proc_anterior->contexto_regs), &(p_proc_actual->contexto_regs));
+
+	/* ceder_mutex (o senalar_cond, si estaba libre) ya le ha dado el mutex */
+	m->cerrojo.cuenta = cuenta;
+	return 0;
+}
+
+/*
+ * Funcion auxiliar que saca al primer proceso de la cola de la condicion
+ * y le da su mutex si esta libre o, si no, lo pasa a la cola del mutex
+ * sin despertarlo. Se llama con las interrupciones inhibidas.
+ */
+static void trasladar_esperando(condicion_ptr c)
+{
+	BCP * proc = c->procesos_bloqueados.primero;
+	mutex_ptr m = proc->mutex_cond;
+
+	proc->mutex_cond = NULL;
+	if (__sync_bool_compare_and_swap(&m->cerrojo.palabra, 0, proc->id + 1))
+	{
+		m->cerrojo.cuenta = 1;
+		desbloquear_proceso(proc, BLOQUEO_CONDICION);
+		return;
+	}
+
+	/* como en sis_lock_mutex: el poseedor tendra que cederselo al liberarlo */
+	eliminar_elem(&c->procesos_bloqueados, proc);
+	proc->cond_espera = NULL;
+	__sync_fetch_and_or(&m->cerrojo.palabra, CERROJO_ESPERAS);
+	m->num_procesos_bloqueados++;
+	proc->mutex_espera = m;
+	insertar_ultimo(&m->procesos_bloqueados, proc);
+	registrar_evento(EV_BLOQUEO, proc->id, BLOQUEO_MUTEX, 0);
+#if PLANIFICACION == PLANIF_PRIO
+	recalcular_prioridad(buscar_BCP(POSEEDOR_MUTEX(m)));	// el poseedor hereda su prioridad.
+#endif
+}
+
+/*
+ * Llamada al sistema senalar_cond. Traslada al primer proceso que espera
+ * en la condicion del registro 1, si lo hay.
+ */
+int sis_senalar_cond()
+{
+	condicion_ptr c = condicion_descriptor((unsigned int)leer_registro(1));
+	int nivel_int;
+
+	if (c == NULL)
+		return -1;
+
+	nivel_int = fijar_nivel_int(3);
+	if (c->procesos_bloqueados.primero != NULL)
+		trasladar_esperando(c);
+	fijar_nivel_int(nivel_int);
+	return 0;
+}
+
+/*
+ * Llamada al sistema difundir_cond. Traslada a todos los procesos que
+ * esperan en la condicion del registro 1.
+ */
+int sis_difundir_cond()
+{
+	condicion_ptr c = condicion_descriptor((unsigned int)leer_registro(1));
+	int nivel_int;
+
+	if (c == NULL)
+		return -1;
+
+	nivel_int = fijar_nivel_int(3);
+	while (c->procesos_bloqueados.primero != NULL)
+		trasladar_esperando(c);
+	fijar_nivel_int(nivel_int);
+	return 0;
+}
+
+/*
+ * Funcion auxiliar que cierra un descriptor de variable condicion del
+ * proceso actual, liberando la entrada cuando ya no la tiene abierta nadie
+ */
+void liberar_cond(int descriptor)
+{
+	condicion_ptr c = p_proc_actual->descriptores_cond[descriptor];
+	condicion_ptr *enlace;
+
+	p_proc_actual->descriptores_cond[descriptor] = NULL;
+	if (--c->num_abiertos > 0)
+		return;
+
+	enlace = &hash_cond[hash_nombre(c->nombre) & (tam_hash_cond - 1)];
+	while (*enlace != c)
+		enlace = &(*enlace)->siguiente;
+	*enlace = c->siguiente;
+
+	c->nombre[0] = '\0';
+	c->estado = LIBRE;
+	c->siguiente = cond_libres;
+	cond_libres = c;
+}
+
+/*
+ * Llamada al sistema cerrar_cond
+ */
+int sis_cerrar_cond()
+{
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+
+	if (condicion_descriptor(descriptor) == NULL)
+		return -1;
+	liberar_cond(descriptor);
+	return 0;
+}
+
+/*
+ *
+ * Funciones relacionadas con los cerrojos de lectores/escritores
+ *	sis_crear_le sis_abrir_le sis_lock_lectura sis_lock_escritura
+ *	sis_unlock_le sis_cerrar_le
+ *
+ * Se organizan como los semaforos. Admiten varios lectores a la vez o un
+ * solo escritor. Los lectores que no encuentran escritor ni esperas se
+ * suman a la palabra del cerrojo desde modo usuario; el kernel solo
+ * interviene para bloquear y para ceder el cerrojo cuando queda libre.
+ * Con PREFERENCIA_ESCRITORES un escritor esperando cierra el paso a los
+ * lectores nuevos y recibe el cerrojo antes que los lectores en espera,
+ * de modo que los escritores no sufren inanicion. Cada proceso lleva en
+ * lecturas_le cuantas lecturas posee de cada descriptor.
+ *
+ */
+
+static void iniciar_tabla_le()
+{
+	int i;
+
+	num_le = leer_parametro_arranque("NUM_LE", NUM_LE);
+
+	for(tam_hash_le = 1; tam_hash_le < (unsigned int)num_le; tam_hash_le <<= 1);
+
+	tabla_le = malloc(num_le * sizeof(lectores_escritores));
+	hash_le = calloc(tam_hash_le, sizeof(le_ptr));
+	if (tabla_le == NULL || hash_le == NULL)
+		panico("no hay memoria para la tabla de cerrojos de lectores/escritores");
+
+	le_libres = NULL;
+	for(i = num_le - 1; i >= 0; i--)
+	{
+		tabla_le[i].estado = LIBRE;
+		tabla_le[i].siguiente = le_libres;
+		le_libres = &tabla_le[i];
+	}
+}
+
+static int buscar_descriptor_le_libre()
+{
+	int i;
+
+	for(i = 0; i < NUM_LE_PROC; i++)
+		if(p_proc_actual->descriptores_le[i] == NULL)
+			return i;
+	return -1;
+}
+
+static le_ptr buscar_nombre_le(char *nombre)
+{
+	le_ptr l;
+
+	for(l = hash_le[hash_nombre(nombre) & (tam_hash_le - 1)]; l != NULL; l = l->siguiente)
+		if(strcmp(l->nombre, nombre) == 0)
+			return l;
+	return NULL;
+}
+
+/*
+ * Devuelve el cerrojo de lectores/escritores de un descriptor del proceso
+ * actual o NULL si no es valido
+ */
+static le_ptr le_descriptor(unsigned int descriptor)
+{
+	if (descriptor >= NUM_LE_PROC)
+		return NULL;
+	return p_proc_actual->descriptores_le[descriptor];
+}
+
+/*
+ * Funcion auxiliar que activa el bit LE_ESPERAS si queda algun proceso en
+ * las colas del cerrojo y lo desactiva si no. Mientras esta activo los
+ * lectores no usan el camino rapido de modo usuario.
+ */
+static void actualizar_esperas_le(le_ptr l)
+{
+	if (l->lectores_bloqueados.primero != NULL || l->escritores_bloqueados.primero != NULL)
+		__sync_fetch_and_or(&l->cerrojo.palabra, LE_ESPERAS);
+	else
+		__sync_fetch_and_and(&l->cerrojo.palabra, ~LE_ESPERAS);
+}
+
+/*
+ * Funcion auxiliar que cede un cerrojo que acaba de quedar libre: al
+ * primer escritor si tiene preferencia o no hay lectores esperando y, si
+ * no, a todos los lectores de la cola, que se despiertan en una sola
+ * pasada. Se llama con las interrupciones inhibidas.
+ */
+static void ceder_le(le_ptr l)
+{
+	BCP * proc;
+	lista_BCPs grupo;
+	int lectores = 0;
+
+	proc = l->escritores_bloqueados.primero;
+	if (proc != NULL &&
+		(l->preferencia == PREFERENCIA_ESCRITORES || l->lectores_bloqueados.primero == NULL))
+	{
+		l->escritor = proc->id;
+		__sync_fetch_and_or(&l->cerrojo.palabra, LE_ESCRITOR);
+		desbloquear_proceso(proc, BLOQUEO_ESCRITURA);
+	}
+	else
+	{
+		/* se desengancha la cola entera y se pasa a listos de una vez */
+		grupo = l->lectores_bloqueados;
+		l->lectores_bloqueados.primero = l->lectores_bloqueados.ultimo = NULL;
+		for (proc = grupo.primero; proc != NULL; proc = proc->siguiente)
+			lectores++;
+		__sync_fetch_and_add(&l->cerrojo.palabra, lectores);
+		desbloquear_grupo(&grupo, BLOQUEO_LECTURA);
+	}
+	actualizar_esperas_le(l);
+}
+
+/*
+ * Funcion auxiliar que suelta la escritura del proceso actual o, si no es
+ * el escritor, el numero de lecturas indicado, y cede el cerrojo si queda
+ * libre
+ */
+static void soltar_le(le_ptr l, int lecturas)
+{
+	int nivel_int;
+
+	if (l->escritor == p_proc_actual->id)
+	{
+		l->escritor = -1;
+		__sync_fetch_and_and(&l->cerrojo.palabra, ~LE_ESCRITOR);
+	}
+	else if ((__sync_sub_and_fetch(&l->cerrojo.palabra, lecturas) & LE_LECTORES) != 0)
+		return;			/* quedan otros lectores */
+
+	nivel_int = fijar_nivel_int(3);
+	ceder_le(l);
+	fijar_nivel_int(nivel_int);
+}
+
+/*
+ * Llamada al sistema crear_le. Crea un cerrojo de lectores/escritores con
+ * el nombre del registro 1 y la preferencia del registro 2 y lo abre.
+ * Devuelve su descriptor, -1 si el nombre es demasiado largo o la
+ * preferencia no es valida, -2 si ya existe, -3 si no hay descriptores
+ * libres y -4 si no hay entradas libres en la tabla.
+ */
+int sis_crear_le()
+{
+	char *nombre = (char *)leer_registro(1);
+	int preferencia = (int)leer_registro(2);
+	int descriptor;
+	unsigned int cubeta;
+	le_ptr l;
+
+	if (strlen(nombre) > MAX_NOM_LE ||
+		(preferencia != PREFERENCIA_LECTORES && preferencia != PREFERENCIA_ESCRITORES))
+		return -1;
+	if (buscar_nombre_le(nombre) != NULL)
+		return -2;
+	if ((descriptor = buscar_descriptor_le_libre()) < 0)
+		return -3;
+	if ((l = le_libres) == NULL)
+		return -4;
+	le_libres = l->siguiente;
+
+	strcpy(l->nombre, nombre);
+	l->estado = OCUPADO;
+	l->cerrojo.palabra = 0;
+	l->preferencia = preferencia;
+	l->escritor = -1;
+	l->lectores_bloqueados.primero = l->lectores_bloqueados.ultimo = NULL;
+	l->escritores_bloqueados.primero = l->escritores_bloqueados.ultimo = NULL;
+	l->num_abiertos = 1;
+
+	cubeta = hash_nombre(nombre) & (tam_hash_le - 1);
+	l->siguiente = hash_le[cubeta];
+	hash_le[cubeta] = l;
+
+	p_proc_actual->descriptores_le[descriptor] = l;
+	p_proc_actual->datos_usuario.cerrojos_le[descriptor] = &l->cerrojo;
+	p_proc_actual->datos_usuario.lecturas_le[descriptor] = 0;
+	return descriptor;
+}
+
+/*
+ * Llamada al sistema abrir_le. Devuelve un descriptor del cerrojo con el
+ * nombre del registro 1 o -1 si no existe o no hay descriptores libres.
+ */
+int sis_abrir_le()
+{
+	char *nombre = (char *)leer_registro(1);
+	int descriptor;
+	le_ptr l;
+
+	if ((descriptor = buscar_descriptor_le_libre()) < 0 ||
+		(l = buscar_nombre_le(nombre)) == NULL)
+		return -1;
+
+	l->num_abiertos++;
+	p_proc_actual->descriptores_le[descriptor] = l;
+	p_proc_actual->datos_usuario.cerrojos_le[descriptor] = &l->cerrojo;
+	p_proc_actual->datos_usuario.lecturas_le[descriptor] = 0;
+	return descriptor;
+}
+
+/*
+ * Llamada al sistema lock_lectura. Adquiere para lectura el cerrojo del
+ * descriptor del registro 1. Solo llega aqui cuando el camino rapido de
+ * la biblioteca no ha podido: se suma a los lectores si no hay escritor y
+ * la preferencia lo permite o si ya posee otra lectura, y si no se
+ * bloquea. Devuelve -1 si el descriptor no es valido o posee la escritura.
+ */
+int sis_lock_lectura()
+{
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+	le_ptr l = le_descriptor(descriptor);
+	BCP * p_proc_anterior;
+	int nivel_int;
+
+	if (l == NULL || l->escritor == p_proc_actual->id)
+		return -1;
+
+	if (!(l->cerrojo.palabra & LE_ESCRITOR) &&
+		(l->preferencia == PREFERENCIA_LECTORES || l->escritores_bloqueados.primero == NULL ||
+		 p_proc_actual->datos_usuario.lecturas_le[descriptor] > 0))
+	{
+		__sync_fetch_and_add(&l->cerrojo.palabra, 1);
+		p_proc_actual->datos_usuario.lecturas_le[descriptor]++;
+		return 0;
+	}
+
+	nivel_int = fijar_nivel_int(3);
+	p_proc_actual->le_espera = l;
+	bloquear_proceso(p_proc_actual, BLOQUEO_LECTURA);
+	actualizar_esperas_le(l);
+	p_proc_anterior = p_proc_actual;
+	p_proc_actual = planificador();
+	fijar_nivel_int(nivel_int);
+	cambio_contexto(&(p_proc_anterior->contexto_regs), &(p_proc_actual->contexto_regs));
+
+	/* ceder_le ya lo ha contado entre los lectores */
+	p_proc_actual->le_espera = NULL;
+	p_proc_actual->datos_usuario.lecturas_le[descriptor]++;
+	return 0;
+}
+
+/*
+ * Llamada al sistema lock_escritura. Adquiere en exclusiva el cerrojo del
+ * descriptor del registro 1, bloqueandose si tiene lectores o escritor.
+ * Devuelve -1 si el descriptor no es valido o el proceso ya posee el
+ * cerrojo, para lectura o para escritura.
+ */
+int sis_lock_escritura()
+{
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+	le_ptr l = le_descriptor(descriptor);
+	BCP * p_proc_anterior;
+	int nivel_int;
+
+	if (l == NULL || l->escritor == p_proc_actual->id ||
+		p_proc_actual->datos_usuario.lecturas_le[descriptor] > 0)
+		return -1;
+
+	if ((l->cerrojo.palabra & ~LE_ESPERAS) == 0)
+	{
+		l->escritor = p_proc_actual->id;
+		__sync_fetch_and_or(&l->cerrojo.palabra, LE_ESCRITOR);
+		return 0;
+	}
+
+	nivel_int = fijar_nivel_int(3);
+	p_proc_actual->le_espera = l;
+	bloquear_proceso(p_proc_actual, BLOQUEO_ESCRITURA);
+	actualizar_esperas_le(l);
+	p_proc_anterior = p_proc_actual;
+	p_proc_actual = planificador();
+	fijar_nivel_int(nivel_int);
+	cambio_contexto(&(p_proc_anterior->contexto_regs), &(p_proc_actual->contexto_regs));
+	return 0;	/* ceder_le ya lo ha hecho escritor */
+}
+
+/*
+ * Llamada al sistema unlock_le. Suelta la escritura o una lectura del
+ * cerrojo del descriptor del registro 1. Devuelve -1 si el descriptor no
+ * es valido o el proceso no posee el cerrojo.
+ */
+int sis_unlock_le()
+{
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+	le_ptr l = le_descriptor(descriptor);
+
+	if (l == NULL)
+		return -1;
+	if (l->escritor != p_proc_actual->id)
+	{
+		if (p_proc_actual->datos_usuario.lecturas_le[descriptor] <= 0)
+			return -1;
+		p_proc_actual->datos_usuario.lecturas_le[descriptor]--;
+	}
+	soltar_le(l, 1);
+	return 0;
+}
+
+/*
+ * Funcion auxiliar que cierra un descriptor de cerrojo de
+ * lectores/escritores del proceso actual, soltando lo que posea de el y
+ * liberando la entrada cuando ya no lo tiene abierto nadie
+ */
+void liberar_le(int descriptor)
+{
+	le_ptr l = p_proc_actual->descriptores_le[descriptor];
+	int lecturas = p_proc_actual->datos_usuario.lecturas_le[descriptor];
+	le_ptr *enlace;
+
+	if (l->escritor == p_proc_actual->id || lecturas > 0)
+		soltar_le(l, lecturas);
+
+	p_proc_actual->descriptores_le[descriptor] = NULL;
+	p_proc_actual->datos_usuario.cerrojos_le[descriptor] = NULL;
+	p_proc_actual->datos_usuario.lecturas_le[descriptor] = 0;
+	if (--l->num_abiertos > 0)
+		return;
+
+	enlace = &hash_le[hash_nombre(l->nombre) & (tam_hash_le - 1)];
+	while (*enlace != l)
+		enlace = &(*enlace)->siguiente;
+	*enlace = l->siguiente;
+
+	l->nombre[0] = '\0';
+	l->estado = LIBRE;
+	l->siguiente = le_libres;
+	le_libres = l;
+}
+
+/*
+ * Llamada al sistema cerrar_le
+ */
+int sis_cerrar_le()
+{
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+
+	if (le_descriptor(descriptor) == NULL)
+		return -1;
+	liberar_le(descriptor);
+	return 0;
+}
+
+/*
+ *
+ * Funciones relacionadas con las barreras
+ *	sis_crear_barrera sis_abrir_barrera sis_esperar_barrera
+ *	sis_cerrar_barrera
+ *
+ * Se organizan como los semaforos. Los procesos que llegan a la barrera
+ * se bloquean en una unica cola hasta que llega el ultimo del grupo, que
+ * separa la cola entera y la pasa a listos de una vez con
+ * desbloquear_grupo. La cuenta vuelve a cero en ese momento, por lo que
+ * la barrera sirve para la fase siguiente sin esperar a que salgan.
+ *
+ */
+
+static void iniciar_tabla_bar()
+{
+	int i;
+
+	num_bar = leer_parametro_arranque("NUM_BAR", NUM_BAR);
+
+	for(tam_hash_bar = 1; tam_hash_bar < (unsigned int)num_bar; tam_hash_bar <<= 1);
+
+	tabla_bar = malloc(num_bar * sizeof(barrera));
+	hash_bar = calloc(tam_hash_bar, sizeof(barrera_ptr));
+	if (tabla_bar == NULL || hash_bar == NULL)
+		panico("no hay memoria para la tabla de barreras");
+
+	bar_libres = NULL;
+	for(i = num_bar - 1; i >= 0; i--)
+	{
+		tabla_bar[i].estado = LIBRE;
+		tabla_bar[i].siguiente = bar_libres;
+		bar_libres = &tabla_bar[i];
+	}
+}
+
+static int buscar_descriptor_bar_libre()
+{
+	int i;
+
+	for(i = 0; i < NUM_BAR_PROC; i++)
+		if(p_proc_actual->descriptores_bar[i] == NULL)
+			return i;
+	return -1;
+}
+
+static barrera_ptr buscar_nombre_bar(char *nombre)
+{
+	barrera_ptr b;
+
+	for(b = hash_bar[hash_nombre(nombre) & (tam_hash_bar - 1)]; b != NULL; b = b->siguiente)
+		if(strcmp(b->nombre, nombre) == 0)
+			return b;
+	return NULL;
+}
+
+/*
+ * Devuelve la barrera de un descriptor del proceso actual o NULL si no es
+ * valido
+ */
+static barrera_ptr barrera_descriptor(unsigned int descriptor)
+{
+	if (descriptor >= NUM_BAR_PROC)
+		return NULL;
+	return p_proc_actual->descriptores_bar[descriptor];
+}
+
+/*
+ * Llamada al sistema crear_barrera. Crea una barrera con el nombre del
+ * registro 1 para grupos del numero de procesos del registro 2 y la abre.
+ * Devuelve su descriptor, -1 si el nombre es demasiado largo o el numero
+ * no es positivo, -2 si ya existe, -3 si no hay descriptores libres y -4
+ * si no hay entradas libres en la tabla.
+ */
+int sis_crear_barrera()
+{
+	char *nombre = (char *)leer_registro(1);
+	int num_procesos = (int)leer_registro(2);
+	int descriptor;
+	unsigned int cubeta;
+	barrera_ptr b;
+
+	if (strlen(nombre) > MAX_NOM_BAR || num_procesos <= 0)
+		return -1;
+	if (buscar_nombre_bar(nombre) != NULL)
+		return -2;
+	if ((descriptor = buscar_descriptor_bar_libre()) < 0)
+		return -3;
+	if ((b = bar_libres) == NULL)
+		return -4;
+	bar_libres = b->siguiente;
+
+	strcpy(b->nombre, nombre);
+	b->estado = OCUPADO;
+	b->num_procesos = num_procesos;
+	b->llegados = 0;
+	b->procesos_bloqueados.primero = b->procesos_bloqueados.ultimo = NULL;
+	b->num_abiertos = 1;
+
+	cubeta = hash_nombre(nombre) & (tam_hash_bar - 1);
+	b->siguiente = hash_bar[cubeta];
+	hash_bar[cubeta] = b;
+
+	p_proc_actual->descriptores_bar[descriptor] = b;
+	return descriptor;
+}
+
+/*
+ * Llamada al sistema abrir_barrera. Devuelve un descriptor de la barrera
+ * con el nombre del registro 1 o -1 si no existe o no hay descriptores
+ * libres.
+ */
+int sis_abrir_barrera()
+{
+	char *nombre = (char *)leer_registro(1);
+	int descriptor;
+	barrera_ptr b;
+
+	if ((descriptor = buscar_descriptor_bar_libre()) < 0 ||
+		(b = buscar_nombre_bar(nombre)) == NULL)
+		return -1;
+
+	b->num_abiertos++;
+	p_proc_actual->descriptores_bar[descriptor] = b;
+	return descriptor;
+}
+
+/*
+ * Llamada al sistema esperar_barrera. Espera en la barrera del descriptor
+ * del registro 1 a que llegue el resto del grupo. El ultimo en llegar no
+ * se bloquea, despierta a los demas y devuelve BARRERA_SERIE; el resto
+ * devuelve 0, y -1 si el descriptor no es valido.
+ */
+int sis_esperar_barrera()
+{
+	barrera_ptr b = barrera_descriptor((unsigned int)leer_registro(1));
+	BCP * p_proc_anterior;
+	lista_BCPs grupo;
+	int nivel_int;
+
+	if (b == NULL)
+		return -1;
+
+	nivel_int = fijar_nivel_int(3);
+	if (++b->llegados == b->num_procesos)
+	{
+		b->llegados = 0;
+		grupo = b->procesos_bloqueados;
+		b->procesos_bloqueados.primero = b->procesos_bloqueados.ultimo = NULL;
+		desbloquear_grupo(&grupo, BLOQUEO_BARRERA);
+		fijar_nivel_int(nivel_int);
+		return BARRERA_SERIE;
+	}
+
+	p_proc_actual->barrera_espera = b;
+	bloquear_proceso(p_proc_actual, BLOQUEO_BARRERA);
+	p_proc_anterior = p_proc_actual;
+	p_proc_actual = planificador();
+	fijar_nivel_int(nivel_int);
+	cambio_contexto(&(p_proc_anterior->contexto_regs), &(p_proc_actual->contexto_regs));
+
+	p_proc_actual->barrera_espera = NULL;
+	return 0;
+}
+
+/*
+ * Funcion auxiliar que cierra un descriptor de barrera del proceso
+ * actual, liberando la entrada cuando ya no la tiene abierta nadie
+ */
+void liberar_barrera(int descriptor)
+{
+	barrera_ptr b = p_proc_actual->descriptores_bar[descriptor];
+	barrera_ptr *enlace;
+
+	p_proc_actual->descriptores_bar[descriptor] = NULL;
+	if (--b->num_abiertos > 0)
+		return;
+
+	enlace = &hash_bar[hash_nombre(b->nombre) & (tam_hash_bar - 1)];
+	while (*enlace != b)
+		enlace = &(*enlace)->siguiente;
+	*enlace = b->siguiente;
+
+	b->nombre[0] = '\0';
+	b->estado = LIBRE;
+	b->siguiente = bar_libres;
+	bar_libres = b;
+}
+
+/*
+ * Llamada al sistema cerrar_barrera
+ */
+int sis_cerrar_barrera()
+{
+	unsigned int descriptor = (unsigned int)leer_registro(1);
+
+	if (barrera_descriptor(descriptor) == NULL)
+		return -1;
+	liberar_barrera(descriptor);
+	return 0;
+}
+
+/*
+ * Lee un parametro entero de arranque de la variable de entorno del
+ * mismo nombre. Si no esta definida o no es positivo devuelve el valor
+ * por defecto.
+ */
+int leer_parametro_arranque(char *nombre, int defecto)
+{
+	char *valor = getenv(nombre);
+	int n;
+
+	if (valor == NULL || (n = atoi(valor)) <= 0)
+		return defecto;
+	return n;
+}
+
 /*
  *
  * Rutina de inicializaci�n invocada en arranque
@@ -929,7 +3576,13 @@ int main(){
 
 	iniciar_buffer();			/* inicia Buffer de terminal */
 	iniciar_tabla_proc();		/* inicia BCPs de tabla de procesos */
+	iniciar_pilas();			/* crea la reserva de pilas de proceso */
+	iniciar_cache_imagenes();	/* fija el tamano de la cache de imagenes */
 	iniciar_tabla_mutex();		/* inicia mutexs de tabla de mutex */
+	iniciar_tabla_sem();		/* inicia la tabla de semaforos */
+	iniciar_tabla_cond();		/* inicia la tabla de variables condicion */
+	iniciar_tabla_le();			/* inicia la tabla de cerrojos de lectores/escritores */
+	iniciar_tabla_bar();		/* inicia la tabla de barreras */
 
 	/* crea proceso inicial */
 	if (crear_tarea((void *)"init")<0)
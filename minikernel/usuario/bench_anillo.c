@@ -0,0 +1,71 @@
+/*
+ * usuario/bench_anillo.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide lo que se ahorra agrupando llamadas en el
+ * anillo. Hace NUM_LLAMADAS llamadas OBTENER_ID una a una con llamsis (la
+ * funcion obtener_id_pr ya no entra en el kernel) y despues las mismas en
+ * tandas de TAM_ANILLO con una sola entrada al kernel cada una,
+ * comprobando los resultados. Termina con una tanda mixta que
+ * escribe, bloquea y libera un mutex y crea un proceso.
+ */
+
+#include "servicios.h"
+#include "../minikernel/include/llamsis.h"
+
+#define NUM_LLAMADAS 200000
+
+int llamsis(int llamada, int nargs, ... /* args */);
+
+static anillo_llamadas anillo;
+
+int main(){
+	int i, n, yo, inicio, t_sueltas, t_anillo, errores=0, mut;
+	finalizacion fin;
+	static char texto[]="bench_anillo: escrito desde el anillo\n";
+
+	yo=obtener_id_pr();
+	iniciar_anillo(&anillo);
+
+	inicio=obtener_ticks();
+	for (i=0; i<NUM_LLAMADAS; i++)
+		if (llamsis(OBTENER_ID, 0)!=yo)
+			errores++;
+	t_sueltas=obtener_ticks()-inicio;
+
+	inicio=obtener_ticks();
+	for (i=0; i<NUM_LLAMADAS; i+=TAM_ANILLO){
+		for (n=0; n<TAM_ANILLO; n++)
+			encolar_llamada(&anillo, i+n, OBTENER_ID, 0);
+		enviar_anillo(&anillo);
+		while (recoger_llamada(&anillo, &fin))
+			if (fin.resultado!=yo)
+				errores++;
+	}
+	t_anillo=obtener_ticks()-inicio;
+
+	printf("bench_anillo: %d llamadas sueltas: %d ticks\n", NUM_LLAMADAS, t_sueltas);
+	printf("bench_anillo: %d llamadas en tandas de %d: %d ticks\n",
+		NUM_LLAMADAS, TAM_ANILLO, t_anillo);
+
+	/* tanda con llamadas de distinto tipo */
+	if ((mut=crear_mutex("m_anillo", NO_RECURSIVO))<0)
+		errores++;
+	encolar_llamada(&anillo, 1, ESCRIBIR, 2, (long)texto, (long)(sizeof(texto)-1));
+	encolar_llamada(&anillo, 2, LOCK_MUTEX, 1, (long)mut);
+	encolar_llamada(&anillo, 3, UNLOCK_MUTEX, 1, (long)mut);
+	encolar_llamada(&anillo, 4, CREAR_PROCESO, 1, (long)"nulo");
+	encolar_llamada(&anillo, 5, NSERVICIOS, 0);
+	n=enviar_anillo(&anillo);
+	while (recoger_llamada(&anillo, &fin))
+		printf("bench_anillo: peticion %ld (llamada %d) -> %d\n",
+			fin.dato, fin.llamada, fin.resultado);
+	esperar_cualquiera(NULL);
+
+	printf("bench_anillo: %d peticiones en la tanda mixta, %d errores\n", n, errores);
+	return 0;
+}
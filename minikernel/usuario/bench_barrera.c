@@ -0,0 +1,141 @@
+/*
+ * usuario/bench_barrera.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide la sincronizacion por fases de un grupo
+ * de NUM_TRABAJADORES procesos del mismo programa, que comparten los
+ * datos estaticos de la imagen. Cada uno anota en que fase esta y, tras
+ * esperar al resto, comprueba que todos han llegado a ella. Se hace
+ * NUM_FASES veces con una barrera del kernel y con una barrera construida
+ * con un mutex, un contador y una variable condicion, y se muestran los
+ * ticks, las llamadas al sistema, los cambios de proceso, las fases en
+ * que algun proceso se ha adelantado y las veces que se ha devuelto
+ * BARRERA_SERIE.
+ */
+
+#include "servicios.h"
+
+#define NUM_TRABAJADORES 8
+#define NUM_FASES 20000
+
+#define MODO_BARRERA 0
+#define MODO_CONDICION 1
+
+static char *nombre_modo[]={"barrera", "mutex+condicion"};
+#define NUM_MODOS (sizeof(nombre_modo)/sizeof(nombre_modo[0]))
+
+/* datos compartidos por los procesos que ejecutan este programa */
+static int fase_de[NUM_TRABAJADORES];
+static int modo_ronda;
+static int siguiente_trabajador;
+static int llegados, generacion;
+static int series;
+static volatile int padre_activo=0;
+
+/* Barrera de referencia: el ultimo en llegar cambia de generacion */
+static int esperar_condicion(int m, int c){
+	int gen, serie=0;
+
+	lock(m);
+	gen=generacion;
+	if (++llegados==NUM_TRABAJADORES){
+		llegados=0;
+		generacion++;
+		difundir_cond(c);
+		serie=BARRERA_SERIE;
+	}
+	else
+		while (gen==generacion)
+			esperar_cond(c, m);
+	unlock(m);
+	return serie;
+}
+
+static int trabajador(){
+	int yo=siguiente_trabajador++;
+	int b=-1, m=-1, c=-1, fase, j, adelantos=0;
+
+	if (modo_ronda==MODO_BARRERA)
+		b=abrir_barrera("fases");
+	else {
+		m=abrir_mutex("fases");
+		c=abrir_cond("fases");
+	}
+
+	for (fase=1; fase<=NUM_FASES; fase++){
+		fase_de[yo]=fase;
+		if (((modo_ronda==MODO_BARRERA) ? esperar_barrera(b) :
+				esperar_condicion(m, c))==BARRERA_SERIE)
+			series++;
+		for (j=0; j<NUM_TRABAJADORES; j++)
+			if (fase_de[j]<fase){
+				adelantos++;
+				break;
+			}
+		/* nadie puede anotar la fase siguiente hasta que todos pasen esta */
+		if (modo_ronda==MODO_BARRERA)
+			esperar_barrera(b);
+		else
+			esperar_condicion(m, c);
+	}
+	return adelantos;
+}
+
+static void ronda(int modo){
+	const pagina_kernel *pag=datos_kernel();
+	int b=-1, m=-1, c=-1, i, estado, adelantos=0, ticks;
+	unsigned long llamadas, cambios;
+
+	modo_ronda=modo;
+	siguiente_trabajador=0;
+	llegados=generacion=series=0;
+	for (i=0; i<NUM_TRABAJADORES; i++)
+		fase_de[i]=0;
+	if (modo==MODO_BARRERA)
+		b=crear_barrera("fases", NUM_TRABAJADORES);
+	else {
+		m=crear_mutex("fases", NO_RECURSIVO);
+		c=crear_cond("fases");
+	}
+	if ((modo==MODO_BARRERA && b<0) || (modo==MODO_CONDICION && (m<0 || c<0))){
+		printf("bench_barrera: error creando la barrera\n");
+		return;
+	}
+
+	ticks=obtener_ticks();
+	llamadas=pag->llamadas;
+	cambios=pag->cambios_proceso;
+	for (i=0; i<NUM_TRABAJADORES; i++)
+		crear_proceso("bench_barrera");
+	while (esperar_cualquiera(&estado)>=0)
+		adelantos+=estado;
+	ticks=obtener_ticks()-ticks;
+	llamadas=pag->llamadas-llamadas;
+	cambios=pag->cambios_proceso-cambios;
+
+	printf("bench_barrera: %-15s %d ticks, %lu llamadas, %lu cambios, %d adelantos, %d series\n",
+		nombre_modo[modo], ticks, llamadas, cambios, adelantos, series);
+	if (modo==MODO_BARRERA)
+		cerrar_barrera(b);
+	else {
+		cerrar_cond(c);
+		cerrar_mutex(m);
+	}
+}
+
+int main(){
+	unsigned int i;
+
+	if (padre_activo)
+		salir(trabajador());
+
+	padre_activo=1;
+	for (i=0; i<NUM_MODOS; i++)
+		ronda(i);
+	padre_activo=0;	/* la imagen puede seguir en la cache */
+	return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * usuario/bench_buffer.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide el rendimiento de un buffer acotado
+ * productor/consumidor sincronizado con semaforos. El proceso inicial
+ * produce NUM_ELEMENTOS enteros y NUM_CONSUMIDORES procesos del mismo
+ * programa, que comparten con el los datos estaticos de la imagen, los
+ * consumen. Se repite con varios tamanos de buffer y se muestran los
+ * ticks, los elementos por tick y los cambios de proceso.
+ */
+
+#include "servicios.h"
+
+#define NUM_ELEMENTOS 100000
+#define NUM_CONSUMIDORES 2
+#define MAX_HUECOS 64
+#define FIN (-1)
+
+static int tamanos[]={1, 8, MAX_HUECOS};
+#define NUM_TAMANOS (sizeof(tamanos)/sizeof(tamanos[0]))
+
+/* datos compartidos por los procesos que ejecutan este programa */
+static int buffer[MAX_HUECOS];
+static int huecos_ronda;
+static int pos_productor, pos_consumidor;
+static volatile int productor_activo=0;
+
+static int consumidor(){
+	int huecos=abrir_sem("huecos"), elementos=abrir_sem("elems");
+	int excl=abrir_sem("excl");
+	int dato, consumidos=0;
+
+	for (;;){
+		esperar_sem(elementos);
+		esperar_sem(excl);
+		dato=buffer[pos_consumidor];
+		pos_consumidor=(pos_consumidor+1)%huecos_ronda;
+		senalar_sem(excl);
+		senalar_sem(huecos);
+		if (dato==FIN)
+			break;
+		consumidos++;
+	}
+	return consumidos;
+}
+
+static void ronda(int tam){
+	const pagina_kernel *pag=datos_kernel();
+	int huecos, elementos, excl, i, estado, consumidos=0, ticks;
+	unsigned long cambios;
+
+	huecos_ronda=tam;
+	pos_productor=pos_consumidor=0;
+	huecos=crear_sem("huecos", tam);
+	elementos=crear_sem("elems", 0);
+	excl=crear_sem("excl", 1);
+	if (huecos<0 || elementos<0 || excl<0){
+		printf("bench_buffer: error creando semaforos\n");
+		return;
+	}
+
+	ticks=obtener_ticks();
+	cambios=pag->cambios_proceso;
+	for (i=0; i<NUM_CONSUMIDORES; i++)
+		crear_proceso("bench_buffer");
+	for (i=0; i<NUM_ELEMENTOS+NUM_CONSUMIDORES; i++){
+		esperar_sem(huecos);
+		buffer[pos_productor]=(i<NUM_ELEMENTOS) ? i : FIN;
+		pos_productor=(pos_productor+1)%tam;
+		senalar_sem(elementos);
+	}
+	while (esperar_cualquiera(&estado)>=0)
+		consumidos+=estado;
+	ticks=obtener_ticks()-ticks;
+	cambios=pag->cambios_proceso-cambios;
+
+	printf("bench_buffer: %2d huecos: %d consumidos en %d ticks, %d por tick, %lu cambios de proceso\n",
+		tam, consumidos, ticks, ticks ? consumidos/ticks : consumidos, cambios);
+	cerrar_sem(huecos);
+	cerrar_sem(elementos);
+	cerrar_sem(excl);
+}
+
+int main(){
+	unsigned int i;
+
+	if (productor_activo)
+		salir(consumidor());
+
+	productor_activo=1;
+	for (i=0; i<NUM_TAMANOS; i++)
+		ronda(tamanos[i]);
+	productor_activo=0;	/* la imagen puede seguir en la cache */
+	return 0;
+}
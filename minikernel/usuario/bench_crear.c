@@ -0,0 +1,59 @@
+/*
+ * usuario/bench_crear.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide el rendimiento de la creacion de procesos.
+ * Crea NUM_LOTES lotes de TAM_LOTE procesos "nulo", que terminan nada mas
+ * empezar, y tras cada lote espera a que terminen todos, de modo
+ * que las entradas de la tabla y las pilas se reciclan continuamente.
+ * Muestra los ticks gastados creando y los totales, que incluyen la
+ * ejecucion y terminacion de los hijos. Se mide creando los procesos
+ * uno a uno con crear_proceso y por lotes con crear_procesos.
+ */
+
+#include "servicios.h"
+
+#define NUM_LOTES 10
+#define TAM_LOTE 1000
+
+static int ids[TAM_LOTE];
+
+static void medir(int por_lotes)
+{
+	int i, j, n, inicio, inicio_lote, ticks_crear=0, ticks, creados=0;
+
+	inicio=obtener_ticks();
+	for (i=0; i<NUM_LOTES; i++){
+		inicio_lote=obtener_ticks();
+		if (por_lotes){
+			if ((n=crear_procesos("nulo", TAM_LOTE, ids))>0)
+				creados+=n;
+		}
+		else
+			for (j=0; j<TAM_LOTE; j++)
+				if (crear_proceso("nulo")>=0)
+					creados++;
+		ticks_crear+=obtener_ticks()-inicio_lote;
+		while (esperar_cualquiera(NULL)>=0)
+			;
+	}
+	ticks=obtener_ticks()-inicio;
+
+	printf("bench_crear: %s: %d procesos, %d ticks creando, %d ticks en total\n",
+		por_lotes ? "crear_procesos" : "crear_proceso",
+		creados, ticks_crear, ticks);
+}
+
+int main(){
+	printf("bench_crear: comienza\n");
+
+	medir(0);
+	medir(1);
+
+	printf("bench_crear: termina\n");
+	return 0;
+}
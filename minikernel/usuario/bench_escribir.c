@@ -0,0 +1,56 @@
+/*
+ * usuario/bench_escribir.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que compara los modos del buffer de salida. Con cada
+ * modo escribe NUM_NUMEROS numeros con printf, NUM_POR_LINEA por linea, y
+ * cuenta en la traza del kernel las llamadas escribir y escribirv que ha
+ * necesitado y los ticks que ha tardado.
+ */
+
+#include "servicios.h"
+#include "../minikernel/include/llamsis.h"
+
+#define NUM_NUMEROS 1800	/* caben en la traza con SALIDA_DIRECTA */
+#define NUM_POR_LINEA 12
+
+static evento_traza eventos[TAM_TRAZA];
+
+static char *nombre_modo[]={"SALIDA_DIRECTA", "SALIDA_LINEA", "SALIDA_COMPLETA"};
+
+/* Devuelve cuantas llamadas de escritura hay en la traza pendiente de leer */
+static int contar_escrituras(){
+	int i, n, llamadas=0;
+
+	n=leer_traza(eventos, TAM_TRAZA);
+	for (i=0; i<n; i++)
+		if (eventos[i].tipo==EV_LLAMADA &&
+				(eventos[i].arg==ESCRIBIR || eventos[i].arg==ESCRIBIRV))
+			llamadas++;
+	return llamadas;
+}
+
+int main(){
+	int modo, i, inicio, ticks[3], llamadas[3];
+
+	for (modo=SALIDA_DIRECTA; modo<=SALIDA_COMPLETA; modo++){
+		fijar_salida(modo);
+		contar_escrituras();
+		inicio=obtener_ticks();
+		for (i=0; i<NUM_NUMEROS; i++)
+			printf(i%NUM_POR_LINEA==NUM_POR_LINEA-1 ? "%4d\n" : "%4d ", i);
+		vaciar_salida();
+		ticks[modo]=obtener_ticks()-inicio;
+		llamadas[modo]=contar_escrituras();
+	}
+
+	fijar_salida(SALIDA_LINEA);
+	for (modo=SALIDA_DIRECTA; modo<=SALIDA_COMPLETA; modo++)
+		printf("bench_escribir: %s: %d llamadas, %d ticks\n",
+			nombre_modo[modo], llamadas[modo], ticks[modo]);
+	return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * usuario/bench_le.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide un acceso mayoritariamente de lectura a
+ * una tabla compartida. NUM_TRABAJADORES procesos del mismo programa, que
+ * comparten los datos estaticos de la imagen, hacen NUM_OPERACIONES
+ * accesos cada uno, de los que uno de cada PERIODO_ESCRITURA reescribe la
+ * tabla y el resto la recorren comprobando que es coherente. Se protege
+ * con un mutex y con un cerrojo de lectores/escritores con cada
+ * preferencia, y se muestran los ticks, las llamadas al sistema, las
+ * lecturas incoherentes y la mayor espera de un escritor.
+ */
+
+#include "servicios.h"
+
+#define NUM_TRABAJADORES 4
+#define NUM_OPERACIONES 20000
+#define PERIODO_ESCRITURA 64
+#define TAM_TABLA 64
+#define PASADAS_LECTURA 200		/* alarga la seccion de lectura */
+
+#define MODO_MUTEX 0
+#define MODO_LECTORES 1
+#define MODO_ESCRITORES 2
+
+static char *nombre_modo[]={"mutex", "le lectores", "le escritores"};
+#define NUM_MODOS (sizeof(nombre_modo)/sizeof(nombre_modo[0]))
+
+/* datos compartidos por los procesos que ejecutan este programa */
+static int tabla[TAM_TABLA];
+static int modo_ronda;
+static int max_espera_escritor;
+static volatile int padre_activo=0;
+
+static void adquirir(int d, int escribir){
+	if (modo_ronda==MODO_MUTEX)
+		lock(d);
+	else if (escribir)
+		lock_escritura(d);
+	else
+		lock_lectura(d);
+}
+
+static void soltar(int d){
+	if (modo_ronda==MODO_MUTEX)
+		unlock(d);
+	else
+		unlock_le(d);
+}
+
+static int trabajador(){
+	int d, i, j, k, espera, incoherentes=0;
+
+	d=(modo_ronda==MODO_MUTEX) ? abrir_mutex("tabla") : abrir_le("tabla");
+	if (d<0)
+		return -1;
+
+	for (i=0; i<NUM_OPERACIONES; i++){
+		if (i%PERIODO_ESCRITURA==0){
+			espera=obtener_ticks();
+			adquirir(d, 1);
+			espera=obtener_ticks()-espera;
+			if (espera>max_espera_escritor)
+				max_espera_escritor=espera;
+			for (j=0; j<TAM_TABLA; j++)
+				tabla[j]++;
+		}
+		else {
+			adquirir(d, 0);
+			for (k=0; k<PASADAS_LECTURA; k++)
+				for (j=1; j<TAM_TABLA; j++)
+					if (tabla[j]!=tabla[0]){
+						incoherentes++;
+						break;
+					}
+		}
+		soltar(d);
+	}
+	return incoherentes;
+}
+
+static void ronda(int modo){
+	const pagina_kernel *pag=datos_kernel();
+	int d, i, estado, incoherentes=0, ticks;
+	unsigned long llamadas;
+
+	modo_ronda=modo;
+	max_espera_escritor=0;
+	d=(modo==MODO_MUTEX) ? crear_mutex("tabla", NO_RECURSIVO) :
+		crear_le("tabla", modo==MODO_LECTORES ? PREFERENCIA_LECTORES : PREFERENCIA_ESCRITORES);
+	if (d<0){
+		printf("bench_le: error creando el cerrojo\n");
+		return;
+	}
+
+	ticks=obtener_ticks();
+	llamadas=pag->llamadas;
+	for (i=0; i<NUM_TRABAJADORES; i++)
+		crear_proceso("bench_le");
+	while (esperar_cualquiera(&estado)>=0)
+		incoherentes+=estado;
+	ticks=obtener_ticks()-ticks;
+	llamadas=pag->llamadas-llamadas;
+
+	printf("bench_le: %-13s %d ticks, %lu llamadas, %d incoherentes, espera maxima de escritor %d ticks\n",
+		nombre_modo[modo], ticks, llamadas, incoherentes, max_espera_escritor);
+	if (modo==MODO_MUTEX)
+		cerrar_mutex(d);
+	else
+		cerrar_le(d);
+}
+
+int main(){
+	unsigned int i;
+
+	if (padre_activo)
+		salir(trabajador());
+
+	padre_activo=1;
+	for (i=0; i<NUM_MODOS; i++)
+		ronda(i);
+	padre_activo=0;	/* la imagen puede seguir en la cache */
+	return 0;
+}
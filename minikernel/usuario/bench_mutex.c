@@ -0,0 +1,53 @@
+/*
+ * usuario/bench_mutex.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide el coste de lock/unlock sin contencion.
+ * Lo compara con el de una llamada al sistema vacia (escribir 0 bytes),
+ * que es lo que costaba cada lock y cada unlock cuando ambos entraban
+ * siempre en el kernel.
+ */
+
+#include "servicios.h"
+
+#define TOT_ITER 1000000
+
+int main(){
+	int i, desc, inicio, t_mutex, t_llamada;
+
+	printf("bench_mutex: comienza\n");
+
+	if ((desc=crear_mutex("bench", NO_RECURSIVO))<0){
+		printf("bench_mutex: error creando mutex\n");
+		return 1;
+	}
+
+	inicio=obtener_ticks();
+	for (i=0; i<TOT_ITER; i++){
+		lock(desc);
+		unlock(desc);
+	}
+	t_mutex=obtener_ticks()-inicio;
+
+	inicio=obtener_ticks();
+	for (i=0; i<TOT_ITER; i++){
+		escribir("", 0);
+		escribir("", 0);
+	}
+	t_llamada=obtener_ticks()-inicio;
+
+	printf("bench_mutex: %d lock/unlock: %d ticks\n", TOT_ITER, t_mutex);
+	printf("bench_mutex: %d pares de llamadas vacias: %d ticks\n",
+		TOT_ITER, t_llamada);
+	if (t_mutex>0)
+		printf("bench_mutex: lock/unlock %d veces mas rapido\n",
+			t_llamada/t_mutex);
+
+	cerrar_mutex(desc);
+	printf("bench_mutex: termina\n");
+	return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * usuario/bench_pagina.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que compara obtener el id y el reloj con una
+ * llamada al sistema y leyendolos de la pagina del kernel, y muestra los
+ * contadores del planificador que esta expone.
+ */
+
+#include "servicios.h"
+#include "../minikernel/include/llamsis.h"
+
+#define NUM_LECTURAS 200000
+
+int llamsis(int llamada, int nargs, ... /* args */);
+
+int main(){
+	const pagina_kernel *pag=datos_kernel();
+	int i, inicio, t_llamada, t_pagina, errores=0;
+	unsigned long cambios, llamadas;
+
+	cambios=pag->cambios_proceso;
+	llamadas=pag->llamadas;
+
+	inicio=obtener_ticks();
+	for (i=0; i<NUM_LECTURAS; i++)
+		if (llamsis(OBTENER_ID, 0)!=pag->actual->id ||
+				llamsis(OBTENER_TICKS, 0)<inicio)
+			errores++;
+	t_llamada=obtener_ticks()-inicio;
+
+	inicio=obtener_ticks();
+	for (i=0; i<NUM_LECTURAS; i++)
+		if (obtener_id_pr()!=pag->actual->id || obtener_ticks()<inicio)
+			errores++;
+	t_pagina=obtener_ticks()-inicio;
+
+	printf("bench_pagina: %d lecturas de id y reloj con llamada: %d ticks\n",
+		NUM_LECTURAS, t_llamada);
+	printf("bench_pagina: %d lecturas de id y reloj de la pagina: %d ticks\n",
+		NUM_LECTURAS, t_pagina);
+	printf("bench_pagina: %lu llamadas y %lu cambios de proceso (%lu expulsiones en total), %d errores\n",
+		pag->llamadas-llamadas, pag->cambios_proceso-cambios, pag->expulsiones, errores);
+	return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * usuario/bench_terminal.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide el reparto de la entrada del terminal entre
+ * varios lectores. Crea NUM_LECTORES procesos lector_bench, que leen hasta
+ * recibir un '.', y espera a que terminen; hay que teclear letras
+ * distintas seguidas de NUM_LECTORES puntos. Despues recorre la traza del
+ * kernel para emparejar cada interrupcion de terminal con la llamada
+ * leer_caracter que devolvio ese caracter, y muestra la latencia desde la
+ * pulsacion hasta la entrega, los caracteres que recibio cada lector y
+ * cuantas veces se desperto a un lector por cada caracter. Compilando el
+ * kernel con una u otra POLITICA_TERMINAL se comparan ambas.
+ */
+
+#include "servicios.h"
+#include "../minikernel/include/llamsis.h"
+
+#define NUM_LECTORES 4
+
+static evento_traza eventos[TAM_TRAZA];
+
+int main(){
+	int ids[NUM_LECTORES];
+	int i, j, n, id, estado;
+	int pulsados=0, entregados=0, despertares=0;
+	unsigned long latencia, total=0, maxima=0;
+
+	printf("bench_terminal: teclea letras distintas y %d puntos\n", NUM_LECTORES);
+
+	/* descarta los eventos anteriores (la propia llamada genera otros) */
+	leer_traza(eventos, TAM_TRAZA);
+
+	if (crear_procesos("lector_bench", NUM_LECTORES, ids)!=NUM_LECTORES)
+		printf("bench_terminal: no se han creado todos los lectores\n");
+
+	while ((id=esperar_cualquiera(&estado))>=0)
+		printf("bench_terminal: lector %d recibio %d caracteres\n", id, estado);
+
+	n=leer_traza(eventos, TAM_TRAZA);
+	for (i=0; i<n; i++){
+		if (eventos[i].tipo==EV_DESPERTAR && eventos[i].arg==BLOQUEO_TERMINAL)
+			despertares++;
+		if (eventos[i].tipo!=EV_INTERRUPCION || eventos[i].arg!=INT_TERMINAL ||
+				eventos[i].valor=='.')
+			continue;
+		pulsados++;
+		for (j=i+1; j<n; j++)
+			if (eventos[j].tipo==EV_FIN_LLAMADA && eventos[j].arg==LEER_CARACTER &&
+					eventos[j].valor==eventos[i].valor){
+				latencia=eventos[j].tick-eventos[i].tick;
+				total+=latencia;
+				if (latencia>maxima)
+					maxima=latencia;
+				entregados++;
+				break;
+			}
+	}
+
+	printf("bench_terminal: %d pulsados, %d entregados, %d despertares\n",
+		pulsados, entregados, despertares);
+	if (entregados>0)
+		printf("bench_terminal: latencia media %lu.%02lu ticks, maxima %lu ticks\n",
+			total/entregados, total*100/entregados%100, maxima);
+	return 0;
+}
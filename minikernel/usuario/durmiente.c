@@ -0,0 +1,20 @@
+/*
+ * usuario/durmiente.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que se queda dormido un buen rato. Lo usa
+ * estres_dormir para tener muchos procesos aparcados en dormir().
+ */
+
+#include "servicios.h"
+
+#define SEGS_DORMIDO 30
+
+int main(){
+	dormir(SEGS_DORMIDO);
+	return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * usuario/estad_llamadas.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que muestra cuanto tiempo pasa el kernel en cada
+ * llamada al sistema. Pone a cero los contadores, ejecuta los programas de
+ * CARGAS esperando a que terminen y saca una tabla con las llamadas
+ * usadas: veces, errores, ticks, porcentaje del tiempo total, latencia
+ * media y los percentiles 50 y 99 (cota superior de su cubeta log2). Con
+ * DETALLE a 1 tambien muestra las cubetas del histograma.
+ */
+
+#include "servicios.h"
+#include "../minikernel/include/llamsis.h"
+
+#define DETALLE 0
+
+static char *cargas[]={"bench_escribir", "bench_anillo"};
+#define NUM_CARGAS (sizeof(cargas)/sizeof(cargas[0]))
+
+static char *nombre_llamada[]={"crear_proceso", "terminar_proceso",
+	"escribir", "obtener_id", "dormir", "crear_mutex", "abrir_mutex",
+	"cerrar_mutex", "lock", "unlock", "leer_caracter", "obtener_ticks",
+	"obtener_pagina", "obtener_estadisticas", "leer_traza",
+	"listar_procesos", "crear_procesos", "esperar_proceso",
+	"esperar_cualquiera", "leer", "escribirv", "procesar_anillo",
+	"volcar_llamadas", "fijar_prioridad", "crear_sem", "abrir_sem",
+	"esperar_sem", "senalar_sem", "cerrar_sem", "crear_cond",
+	"abrir_cond", "esperar_cond", "senalar_cond", "difundir_cond",
+	"cerrar_cond", "crear_le", "abrir_le", "lock_lectura",
+	"lock_escritura", "unlock_le", "cerrar_le", "crear_barrera",
+	"abrir_barrera", "esperar_barrera", "cerrar_barrera"};
+#define NUM_NOMBRES ((int)(sizeof(nombre_llamada)/sizeof(nombre_llamada[0])))
+
+static estadisticas_llamada est[NSERVICIOS];
+
+/* Devuelve la cota superior en ns de la cubeta en que cae el percentil */
+static unsigned long percentil(estadisticas_llamada *e, int porcentaje){
+	unsigned long acumuladas=0;
+	int i;
+
+	for (i=0; i<CUBETAS_LATENCIA-1; i++){
+		acumuladas+=e->cubetas[i];
+		if (acumuladas*100>=e->llamadas*porcentaje)
+			break;
+	}
+	return 2UL<<i;
+}
+
+int main(){
+	unsigned int i;
+	int j, n;
+	unsigned long total_ns=0;
+
+	volcar_llamadas(est, NSERVICIOS, 1);
+	for (i=0; i<NUM_CARGAS; i++)
+		if (crear_proceso(cargas[i])<0)
+			printf("estad_llamadas: error creando %s\n", cargas[i]);
+	while (esperar_cualquiera(NULL)>=0)
+		;
+
+	n=volcar_llamadas(est, NSERVICIOS, 0);
+	if (n>NSERVICIOS)
+		n=NSERVICIOS;
+	for (j=0; j<n; j++)
+		total_ns+=est[j].ns;
+
+	printf("LLAMADA                     VECES ERRORES  TICKS  %%TIEMPO  MEDIA(ns)   P50(ns)   P99(ns)\n");
+	for (j=0; j<n; j++){
+		if (est[j].llamadas==0)
+			continue;
+		printf("%-22s %10lu %7lu %6lu %5lu.%lu %10lu %9lu %9lu\n",
+			j<NUM_NOMBRES ? nombre_llamada[j] : "?",
+			est[j].llamadas, est[j].errores, est[j].ticks,
+			total_ns ? est[j].ns*100/total_ns : 0,
+			total_ns ? est[j].ns*1000/total_ns%10 : 0,
+			est[j].ns/est[j].llamadas, percentil(&est[j], 50), percentil(&est[j], 99));
+		if (DETALLE)
+			for (i=0; i<CUBETAS_LATENCIA; i++)
+				if (est[j].cubetas[i])
+					printf("    [2^%u, 2^%u) ns: %lu\n", i, i+1, est[j].cubetas[i]);
+	}
+	return 0;
+}
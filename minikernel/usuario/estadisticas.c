@@ -0,0 +1,35 @@
+/*
+ * usuario/estadisticas.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que muestra las estadisticas de uso de UCP de todos
+ * los procesos existentes, para localizar los que mas consumen.
+ */
+
+#include "servicios.h"
+
+#define MAX_LISTADOS 1024
+
+static int ids[MAX_LISTADOS];
+
+int main(){
+	estadisticas_proceso est;
+	int i, n;
+
+	n=listar_procesos(ids, MAX_LISTADOS);
+	if (n>MAX_LISTADOS)
+		n=MAX_LISTADOS;
+
+	printf("        ID EST   T.USU   T.SIS  C.VOL C.INVOL  ESPERA\n");
+	for (i=0; i<n; i++)
+		if (obtener_estadisticas(ids[i], &est)==0)
+			printf("%10d %3d %7lu %7lu %6lu %7lu %7lu\n", est.id, est.estado,
+				est.ticks_modo_usuario, est.ticks_modo_sistema,
+				est.cambios_voluntarios, est.cambios_involuntarios,
+				est.ticks_espera_listo);
+	return 0;
+}
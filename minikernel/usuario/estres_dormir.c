@@ -0,0 +1,57 @@
+/*
+ * usuario/estres_dormir.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que mide el coste del tratamiento de la interrupcion
+ * de reloj con muchos procesos dormidos. Durante SEGS_MEDIDA segundos lee
+ * de la pagina del kernel los ticks y los nanosegundos que el kernel ha
+ * dedicado a tratarlos, y muestra el coste medio por tick antes y despues
+ * de aparcar NUM_DORMILONES procesos "durmiente".
+ */
+
+#include "servicios.h"
+
+#define NUM_DORMILONES 2000	/* la tabla de procesos crece hasta alojarlos */
+#define SEGS_MEDIDA 3		/* menos de lo que duermen los hijos */
+
+/* Devuelve los ns medios que ha costado cada tick durante la medida */
+static unsigned long medir_reloj()
+{
+	const pagina_kernel *pag=datos_kernel();
+	unsigned long ticks, ns;
+
+	ticks=pag->ticks;
+	ns=pag->ns_reloj;
+	dormir(SEGS_MEDIDA);
+	ticks=pag->ticks-ticks;
+	ns=pag->ns_reloj-ns;
+	return (ticks>0) ? ns/ticks : 0;
+}
+
+int main(){
+	int creados;
+	unsigned long antes, despues;
+
+	printf("estres_dormir: comienza\n");
+
+	antes=medir_reloj();
+	printf("estres_dormir: sin dormidos: %lu ns por tick\n", antes);
+
+	for (creados=0; creados<NUM_DORMILONES; creados++)
+		if (crear_proceso("durmiente")<0)
+			break;
+	printf("estres_dormir: %d procesos durmiente creados\n", creados);
+
+	/* deja que los hijos ejecuten y se queden dormidos */
+	dormir(1);
+
+	despues=medir_reloj();
+	printf("estres_dormir: con %d dormidos: %lu ns por tick\n", creados, despues);
+
+	printf("estres_dormir: termina\n");
+	return 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * usuario/herencia_alto.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Proceso de prioridad alta de prueba_herencia: pide el mutex "m_pi",
+ * que tiene el de prioridad baja, y termina devolviendo los ticks que ha
+ * esperado por el.
+ */
+
+#include "servicios.h"
+
+int main(){
+	int mut, inicio, espera;
+
+	fijar_prioridad(1);
+	mut=abrir_mutex("m_pi");
+	inicio=obtener_ticks();
+	printf("herencia_alto: pide el mutex\n");
+	lock(mut);
+	espera=obtener_ticks()-inicio;
+	printf("herencia_alto: obtiene el mutex\n");
+	unlock(mut);
+	salir(espera);
+	return 0;
+}
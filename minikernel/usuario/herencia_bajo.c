@@ -0,0 +1,30 @@
+/*
+ * usuario/herencia_bajo.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Proceso de prioridad baja de prueba_herencia: calcula con el mutex
+ * "m_pi" cogido y termina devolviendo los ticks que lo ha tenido.
+ */
+
+#include "servicios.h"
+
+#define ITER_SECCION 1500000000
+
+int main(){
+	volatile int i;
+	int mut, inicio;
+
+	fijar_prioridad(3);
+	mut=abrir_mutex("m_pi");
+	lock(mut);
+	inicio=obtener_ticks();
+	printf("herencia_bajo: entra en la seccion critica\n");
+	for (i=0; i<ITER_SECCION; i++);
+	printf("herencia_bajo: sale de la seccion critica\n");
+	salir(obtener_ticks()-inicio);	/* libera el mutex al terminar */
+	return 0;
+}
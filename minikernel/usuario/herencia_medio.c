@@ -0,0 +1,28 @@
+/*
+ * usuario/herencia_medio.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Proceso de prioridad media de prueba_herencia: calcula sin usar el
+ * mutex y termina devolviendo los ticks que ha tardado.
+ */
+
+#include "servicios.h"
+
+#define ITER_CALCULO 2000000000
+
+int main(){
+	volatile int i;
+	int inicio;
+
+	fijar_prioridad(2);
+	inicio=obtener_ticks();
+	printf("herencia_medio: empieza a calcular\n");
+	for (i=0; i<ITER_CALCULO; i++);
+	printf("herencia_medio: termina de calcular\n");
+	salir(obtener_ticks()-inicio);
+	return 0;
+}
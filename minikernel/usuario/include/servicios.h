@@ -19,9 +19,15 @@
 #ifndef SERVICIOS_H
 #define SERVICIOS_H
 
+/* Estructuras compartidas con el kernel (estadisticas_proceso, ...) */
+#include "../../minikernel/include/compartido.h"
+
 #define NO_RECURSIVO 0
 #define RECURSIVO 1
 
+#define PREFERENCIA_LECTORES 0
+#define PREFERENCIA_ESCRITORES 1
+
 /* Evita el uso del printf de la bilioteca est�ndar */
 #define printf escribirf
 
@@ -31,7 +37,11 @@ int escribirf(const char *formato, ...);
 /* Llamadas al sistema proporcionadas */
 int crear_proceso(char *prog);
 int terminar_proceso();
+int salir(int estado);
 int escribir(char *texto, unsigned int longi);
+int escribirv(fragmento *frag, int n);
+int vaciar_salida();
+int fijar_salida(int modo);
 int obtener_id_pr();
 int dormir(unsigned int segundos);
 int crear_mutex(char * nombre, int tipo);
@@ -39,7 +49,45 @@ int abrir_mutex(char * nombre);
 int lock(unsigned int mutexid);
 int unlock(unsigned int mutexid);
 int cerrar_mutex(unsigned int mutexid);
+int crear_sem(char *nombre, int valor);
+int abrir_sem(char *nombre);
+int esperar_sem(unsigned int semid);
+int senalar_sem(unsigned int semid);
+int cerrar_sem(unsigned int semid);
+int crear_cond(char *nombre);
+int abrir_cond(char *nombre);
+int esperar_cond(unsigned int condid, unsigned int mutexid);
+int senalar_cond(unsigned int condid);
+int difundir_cond(unsigned int condid);
+int cerrar_cond(unsigned int condid);
+int crear_le(char *nombre, int preferencia);
+int abrir_le(char *nombre);
+int lock_lectura(unsigned int leid);
+int lock_escritura(unsigned int leid);
+int unlock_le(unsigned int leid);
+int cerrar_le(unsigned int leid);
+int crear_barrera(char *nombre, int num_procesos);
+int abrir_barrera(char *nombre);
+int esperar_barrera(unsigned int barreraid);
+int cerrar_barrera(unsigned int barreraid);
+int fijar_prioridad(int prioridad);
 int leer_caracter();
+int obtener_ticks();
+const pagina_kernel *datos_kernel();
+int obtener_estadisticas(int id, estadisticas_proceso *est);
+int leer_traza(evento_traza *buf, int max);
+int listar_procesos(int *ids, int max);
+int volcar_llamadas(estadisticas_llamada *est, int max, int reiniciar);
+int crear_procesos(char *prog, int n, int *ids);
+int esperar_proceso(int id, int *estado);
+int esperar_cualquiera(int *estado);
+int leer(char *buf, int n, int modo);
+
+/* Anillo de llamadas agrupadas */
+void iniciar_anillo(anillo_llamadas *anillo);
+int encolar_llamada(anillo_llamadas *anillo, long dato, int llamada, int nargs, ...);
+int enviar_anillo(anillo_llamadas *anillo);
+int recoger_llamada(anillo_llamadas *anillo, finalizacion *fin);
 
 #endif /* SERVICIOS_H */
 
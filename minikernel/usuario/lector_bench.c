@@ -0,0 +1,31 @@
+/*
+ * usuario/lector_bench.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario basado en lector que lee caracteres del teclado
+ * hasta recibir un '.', simulando algo de proceso por cada uno. Termina
+ * devolviendo cuantos ha recibido. Lo usa bench_terminal.
+ */
+
+#include "servicios.h"
+
+#define ITER_PROCESO 30000000	/* calculo por caracter recibido */
+
+int main(){
+	volatile int j;
+	int car, recibidos=0;
+
+	for (;;){
+		car=leer_caracter();
+		if (car=='.')
+			break;
+		recibidos++;
+		for (j=0; j<ITER_PROCESO; j++);
+	}
+	salir(recibidos);
+	return 0;	/* no deberia llegar aqui */
+}
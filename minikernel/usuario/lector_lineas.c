@@ -0,0 +1,48 @@
+/*
+ * usuario/lector_lineas.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la llamada leer. Duerme unos segundos
+ * para que se acumule lo que se teclee, y despues lee linea a linea con
+ * LEER_LINEA hasta recibir "fin". Por ultimo lee con LEER_CARACTERES, que
+ * devuelve lo que haya disponible sin esperar al fin de linea.
+ */
+
+#include "servicios.h"
+
+#define TAM_LINEA 80
+
+int main(){
+	char linea[TAM_LINEA+1];
+	int n, id;
+
+	id=obtener_id_pr();
+	printf("lector_lineas (%d): escribe lineas; \"fin\" para terminar\n", id);
+	dormir(2);
+
+	for (;;){
+		n=leer(linea, TAM_LINEA, LEER_LINEA);
+		if (n<0)
+			break;
+		linea[n]='\0';
+		printf("lector_lineas (%d): %d caracteres: %s", id, n, linea);
+		if (n>0 && linea[n-1]!='\n')
+			printf("\n");
+		if (n==4 && linea[0]=='f' && linea[1]=='i' && linea[2]=='n')
+			break;
+	}
+
+	printf("lector_lineas (%d): pulsa caracteres\n", id);
+	n=leer(linea, TAM_LINEA, LEER_CARACTERES);
+	if (n>=0){
+		linea[n]='\0';
+		printf("lector_lineas (%d): %d caracteres: %s\n", id, n, linea);
+	}
+
+	printf("lector_lineas (%d): termina\n", id);
+	return 0;
+}
@@ -16,7 +16,11 @@
  *
  */
 
+#include <stdarg.h>
+#include <string.h>
+
 #include "llamsis.h"
+#include "compartido.h"
 #include "servicios.h"
 
 /* Funci�n del m�dulo "misc" que prepara el c�digo de la llamada
@@ -26,6 +30,39 @@
 
 int llamsis(int llamada, int nargs, ... /* args */);
 
+/* Pagina de datos del kernel; se obtiene con una llamada la primera vez */
+static pagina_kernel *pagina=NULL;
+
+static pagina_kernel *obtener_pagina(){
+	if (pagina==NULL)
+		llamsis(OBTENER_PAGINA, 1, (long)&pagina);
+	return pagina;
+}
+
+
+/*
+ * Vacia el buffer de salida del proceso con una sola llamada escribirv,
+ * seguido del texto indicado si no es NULL
+ */
+static int vaciar(datos_proceso *yo, char *texto, unsigned int longi){
+	fragmento frag[2];
+	int n=0, res;
+
+	if (yo->num_salida>0){
+		frag[n].texto=yo->salida;
+		frag[n++].longi=yo->num_salida;
+	}
+	if (texto!=NULL && longi>0){
+		frag[n].texto=texto;
+		frag[n++].longi=longi;
+	}
+	if (n==0)
+		return 0;
+	res=llamsis(ESCRIBIRV, 2, (long)frag, (long)n);
+	yo->num_salida=0;
+	return res;
+}
+
 
 /*
  *
@@ -38,13 +75,56 @@ int crear_proceso(char *prog){
 	return llamsis(CREAR_PROCESO, 1, (long)prog);
 }
 int terminar_proceso(){
-	return llamsis(TERMINAR_PROCESO, 0);
+	return llamsis(TERMINAR_PROCESO, 1, 0L);
+}
+int salir(int estado){
+	return llamsis(TERMINAR_PROCESO, 1, (long)estado);
 }
+
+/*
+ * escribir, y con ella escribirf (printf), acumula el texto en el buffer
+ * de salida de los datos del proceso y solo entra en el kernel al vaciarlo
+ * segun el modo fijado con fijar_salida (por defecto SALIDA_LINEA). Lo que
+ * no quepa se escribe junto con lo pendiente en la misma llamada.
+ */
 int escribir(char *texto, unsigned int longi){
-	return llamsis(ESCRIBIR, 2, (long)texto, (long)longi);
+	datos_proceso *yo=obtener_pagina()->actual;
+
+	if (yo->modo_salida==SALIDA_DIRECTA)
+		return llamsis(ESCRIBIR, 2, (long)texto, (long)longi);
+	if (yo->num_salida+longi>TAM_BUF_SALIDA)
+		return vaciar(yo, texto, longi)<0 ? -1 : 0;
+	memcpy(yo->salida+yo->num_salida, texto, longi);
+	yo->num_salida+=longi;
+	if (yo->num_salida==TAM_BUF_SALIDA ||
+			(yo->modo_salida==SALIDA_LINEA && memchr(texto, '\n', longi)!=NULL))
+		return vaciar(yo, NULL, 0)<0 ? -1 : 0;
+	return 0;
+}
+int escribirv(fragmento *frag, int n){
+	vaciar(obtener_pagina()->actual, NULL, 0);
+	return llamsis(ESCRIBIRV, 2, (long)frag, (long)n);
 }
+int vaciar_salida(){
+	return vaciar(obtener_pagina()->actual, NULL, 0);
+}
+int fijar_salida(int modo){
+	datos_proceso *yo=obtener_pagina()->actual;
+	int anterior=yo->modo_salida;
+
+	if (modo<SALIDA_DIRECTA || modo>SALIDA_COMPLETA)
+		return -1;
+	vaciar(yo, NULL, 0);
+	yo->modo_salida=modo;
+	return anterior;
+}
+
+/*
+ * obtener_id_pr y obtener_ticks leen la pagina del kernel sin entrar en
+ * el: actual siempre apunta a los datos del proceso que la lee.
+ */
 int obtener_id_pr(){
-    return llamsis(OBTENER_ID, 0);
+    return obtener_pagina()->actual->id;
 }
 int dormir (unsigned int segundos){
     return llamsis(DORMIR, 1, (long)segundos);
@@ -55,17 +135,237 @@ int crear_mutex(char * nombre, int tipo){
 int abrir_mutex(char * nombre){
     return llamsis(ABRIR_MUTEX, 1, (long)nombre);
 }
+
+/*
+ * lock y unlock solo entran en el kernel cuando hay contencion: un mutex
+ * libre se adquiere, y uno sin procesos esperando se libera, con una
+ * operacion atomica sobre la palabra de cerrojo compartida con el kernel.
+ */
 int lock(unsigned int mutexid){
+    datos_proceso *yo;
+    cerrojo_usuario *c;
+
+    if (mutexid>=NUM_MUT_PROC ||
+        (c=(yo=obtener_pagina()->actual)->cerrojos[mutexid])==NULL)
+        return llamsis(LOCK_MUTEX, 1, (long)mutexid);
+
+    if (__sync_bool_compare_and_swap(&c->palabra, 0, yo->id+1)){
+        c->cuenta=1;
+        return 0;
+    }
+    if ((c->palabra & ~CERROJO_ESPERAS)==yo->id+1){
+        if (c->tipo!=RECURSIVO)
+            return -1;
+        c->cuenta++;
+        return 0;
+    }
     return llamsis(LOCK_MUTEX, 1, (long)mutexid);
 }
 int unlock(unsigned int mutexid){
+    datos_proceso *yo;
+    cerrojo_usuario *c;
+
+    if (mutexid>=NUM_MUT_PROC ||
+        (c=(yo=obtener_pagina()->actual)->cerrojos[mutexid])==NULL)
+        return llamsis(UNLOCK_MUTEX, 1, (long)mutexid);
+
+    if ((c->palabra & ~CERROJO_ESPERAS)!=yo->id+1)
+        return 0;
+    if (c->cuenta>1){
+        c->cuenta--;
+        return 0;
+    }
+    c->cuenta=0;
+    if (__sync_bool_compare_and_swap(&c->palabra, yo->id+1, 0))
+        return 0;
+    /* hay procesos esperando: el kernel se lo cede al primero */
+    c->cuenta=1;
     return llamsis(UNLOCK_MUTEX, 1, (long)mutexid);
 }
 int cerrar_mutex(unsigned int mutexid){
     return llamsis(CERRAR_MUTEX, 1, (long)mutexid);
 }
+int crear_sem(char *nombre, int valor){
+    return llamsis(CREAR_SEM, 2, (long)nombre, (long)valor);
+}
+int abrir_sem(char *nombre){
+    return llamsis(ABRIR_SEM, 1, (long)nombre);
+}
+int esperar_sem(unsigned int semid){
+    return llamsis(ESPERAR_SEM, 1, (long)semid);
+}
+int senalar_sem(unsigned int semid){
+    return llamsis(SENALAR_SEM, 1, (long)semid);
+}
+int cerrar_sem(unsigned int semid){
+    return llamsis(CERRAR_SEM, 1, (long)semid);
+}
+int crear_cond(char *nombre){
+    return llamsis(CREAR_COND, 1, (long)nombre);
+}
+int abrir_cond(char *nombre){
+    return llamsis(ABRIR_COND, 1, (long)nombre);
+}
+int esperar_cond(unsigned int condid, unsigned int mutexid){
+    return llamsis(ESPERAR_COND, 2, (long)condid, (long)mutexid);
+}
+int senalar_cond(unsigned int condid){
+    return llamsis(SENALAR_COND, 1, (long)condid);
+}
+int difundir_cond(unsigned int condid){
+    return llamsis(DIFUNDIR_COND, 1, (long)condid);
+}
+int cerrar_cond(unsigned int condid){
+    return llamsis(CERRAR_COND, 1, (long)condid);
+}
+int crear_le(char *nombre, int preferencia){
+    return llamsis(CREAR_LE, 2, (long)nombre, (long)preferencia);
+}
+int abrir_le(char *nombre){
+    return llamsis(ABRIR_LE, 1, (long)nombre);
+}
+
+/*
+ * lock_lectura y unlock_le no entran en el kernel para un lector mientras
+ * el cerrojo no tenga escritor ni procesos esperando: el lector se suma o
+ * se resta de la palabra del cerrojo con una operacion atomica.
+ */
+int lock_lectura(unsigned int leid){
+    datos_proceso *yo;
+    cerrojo_le *c;
+    int palabra;
+
+    if (leid>=NUM_LE_PROC ||
+        (c=(yo=obtener_pagina()->actual)->cerrojos_le[leid])==NULL)
+        return llamsis(LOCK_LECTURA, 1, (long)leid);
+
+    while (((palabra=c->palabra) & (LE_ESCRITOR|LE_ESPERAS))==0)
+        if (__sync_bool_compare_and_swap(&c->palabra, palabra, palabra+1)){
+            yo->lecturas_le[leid]++;
+            return 0;
+        }
+    return llamsis(LOCK_LECTURA, 1, (long)leid);
+}
+int lock_escritura(unsigned int leid){
+    return llamsis(LOCK_ESCRITURA, 1, (long)leid);
+}
+int unlock_le(unsigned int leid){
+    datos_proceso *yo;
+    cerrojo_le *c;
+    int palabra;
+
+    if (leid>=NUM_LE_PROC ||
+        (c=(yo=obtener_pagina()->actual)->cerrojos_le[leid])==NULL ||
+        yo->lecturas_le[leid]<=0)
+        return llamsis(UNLOCK_LE, 1, (long)leid);
+
+    while (((palabra=c->palabra) & (LE_ESCRITOR|LE_ESPERAS))==0)
+        if (__sync_bool_compare_and_swap(&c->palabra, palabra, palabra-1)){
+            yo->lecturas_le[leid]--;
+            return 0;
+        }
+    /* hay procesos esperando: el kernel cede el cerrojo si queda libre */
+    return llamsis(UNLOCK_LE, 1, (long)leid);
+}
+int cerrar_le(unsigned int leid){
+    return llamsis(CERRAR_LE, 1, (long)leid);
+}
+int crear_barrera(char *nombre, int num_procesos){
+    return llamsis(CREAR_BARRERA, 2, (long)nombre, (long)num_procesos);
+}
+int abrir_barrera(char *nombre){
+    return llamsis(ABRIR_BARRERA, 1, (long)nombre);
+}
+int esperar_barrera(unsigned int barreraid){
+    return llamsis(ESPERAR_BARRERA, 1, (long)barreraid);
+}
+int cerrar_barrera(unsigned int barreraid){
+    return llamsis(CERRAR_BARRERA, 1, (long)barreraid);
+}
+int fijar_prioridad(int prioridad){
+    return llamsis(FIJAR_PRIORIDAD, 1, (long)prioridad);
+}
 int leer_caracter(){
+    vaciar(obtener_pagina()->actual, NULL, 0);	/* muestra lo pedido antes */
     return llamsis(LEER_CARACTER, 0);
 }
+int obtener_ticks(){
+    return (int)obtener_pagina()->ticks;
+}
+const pagina_kernel *datos_kernel(){
+    return obtener_pagina();
+}
+int obtener_estadisticas(int id, estadisticas_proceso *est){
+    return llamsis(OBTENER_ESTADISTICAS, 2, (long)id, (long)est);
+}
+
+int leer_traza(evento_traza *buf, int max){
+    return llamsis(LEER_TRAZA, 2, (long)buf, (long)max);
+}
 
+int listar_procesos(int *ids, int max){
+    return llamsis(LISTAR_PROCESOS, 2, (long)ids, (long)max);
+}
+
+int volcar_llamadas(estadisticas_llamada *est, int max, int reiniciar){
+    return llamsis(VOLCAR_LLAMADAS, 3, (long)est, (long)max, (long)reiniciar);
+}
+
+int crear_procesos(char *prog, int n, int *ids){
+    return llamsis(CREAR_PROCESOS, 3, (long)prog, (long)n, (long)ids);
+}
+
+int esperar_proceso(int id, int *estado){
+    return llamsis(ESPERAR_PROCESO, 2, (long)id, (long)estado);
+}
+
+int esperar_cualquiera(int *estado){
+    return llamsis(ESPERAR_CUALQUIERA, 1, (long)estado);
+}
+
+int leer(char *buf, int n, int modo){
+    vaciar(obtener_pagina()->actual, NULL, 0);
+    return llamsis(LEER, 3, (long)buf, (long)n, (long)modo);
+}
 
+/*
+ * Anillo de llamadas: encolar_llamada prepara una peticion con nargs
+ * argumentos de tipo long (como en llamsis), enviar_anillo ejecuta todas
+ * las pendientes con una sola entrada al kernel y recoger_llamada saca el
+ * siguiente resultado (devuelve 0 si no queda ninguno).
+ */
+void iniciar_anillo(anillo_llamadas *anillo){
+    memset(anillo, 0, sizeof(*anillo));
+}
+
+int encolar_llamada(anillo_llamadas *anillo, long dato, int llamada, int nargs, ...){
+    peticion *pet;
+    va_list ap;
+    int i;
+
+    if (anillo->sub_cola-anillo->sub_cabeza==TAM_ANILLO ||
+        nargs<0 || nargs>ARGS_PETICION)
+        return -1;
+    pet=&anillo->peticiones[anillo->sub_cola & (TAM_ANILLO-1)];
+    pet->llamada=llamada;
+    pet->dato=dato;
+    va_start(ap, nargs);
+    for (i=0; i<nargs; i++)
+        pet->args[i]=va_arg(ap, long);
+    va_end(ap);
+    anillo->sub_cola++;
+    return 0;
+}
+
+int enviar_anillo(anillo_llamadas *anillo){
+    vaciar(obtener_pagina()->actual, NULL, 0);	/* conserva el orden de la salida */
+    return llamsis(PROCESAR_ANILLO, 1, (long)anillo);
+}
+
+int recoger_llamada(anillo_llamadas *anillo, finalizacion *fin){
+    if (anillo->fin_cabeza==anillo->fin_cola)
+        return 0;
+    *fin=anillo->finalizaciones[anillo->fin_cabeza & (TAM_ANILLO-1)];
+    anillo->fin_cabeza++;
+    return 1;
+}
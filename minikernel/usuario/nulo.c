@@ -0,0 +1,18 @@
+/*
+ * usuario/nulo.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que termina nada mas empezar. Lo usa bench_crear
+ * para medir el coste de crear y terminar un proceso.
+ */
+
+#include "servicios.h"
+
+int main(){
+	terminar_proceso();
+	return 0;	/* no deberia llegar aqui */
+}
@@ -0,0 +1,77 @@
+/*
+ * usuario/prueba_condicion.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las variables condicion. Crea NUM_HIJOS
+ * procesos del mismo programa, que comparten con el los datos estaticos
+ * de la imagen. Cada hijo toma un turno, en orden inverso al de creacion,
+ * espera en la condicion "c_turno" a que le toque, anota su turno y
+ * difunde la condicion. Al final se comprueba el orden y se muestran los
+ * cambios de proceso: con el paso de los despertados a la cola del mutex
+ * cada difusion no provoca que todos compitan de nuevo por el.
+ */
+
+#include "servicios.h"
+
+#define NUM_HIJOS 5
+
+/* datos compartidos por los procesos que ejecutan este programa */
+static int asignados, turno;
+static int orden[NUM_HIJOS];
+static volatile int padre_activo=0;
+
+static void hijo(){
+	int mut=abrir_mutex("m_turno"), cond=abrir_cond("c_turno");
+	int mio, esperas=0;
+
+	lock(mut);
+	mio=NUM_HIJOS-1-asignados++;
+	while (turno!=mio){
+		esperar_cond(cond, mut);
+		esperas++;
+	}
+	orden[turno++]=mio;
+	printf("prueba_condicion: turno %d tras %d esperas\n", mio, esperas);
+	difundir_cond(cond);
+	unlock(mut);
+}
+
+int main(){
+	const pagina_kernel *pag=datos_kernel();
+	unsigned long cambios;
+	int i, mut, cond, correcto=1;
+
+	if (padre_activo){
+		hijo();
+		return 0;
+	}
+
+	mut=crear_mutex("m_turno", NO_RECURSIVO);
+	cond=crear_cond("c_turno");
+	if (mut<0 || cond<0){
+		printf("prueba_condicion: error creando mutex o condicion\n");
+		return 1;
+	}
+	printf("prueba_condicion: esperar sin poseer el mutex devuelve %d. DEBE SER -1\n",
+		esperar_cond(cond, mut));
+
+	padre_activo=1;
+	asignados=turno=0;
+	cambios=pag->cambios_proceso;
+	for (i=0; i<NUM_HIJOS; i++)
+		crear_proceso("prueba_condicion");
+	while (esperar_cualquiera(NULL)>=0)
+		;
+	padre_activo=0;	/* la imagen puede seguir en la cache */
+
+	for (i=0; i<NUM_HIJOS; i++)
+		if (orden[i]!=i)
+			correcto=0;
+	printf("prueba_condicion: orden %s, %lu cambios de proceso\n",
+		correcto ? "correcto" : "INCORRECTO", pag->cambios_proceso-cambios);
+	return 0;
+}
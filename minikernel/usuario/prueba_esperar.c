@@ -0,0 +1,46 @@
+/*
+ * usuario/prueba_esperar.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba las llamadas esperar_proceso y
+ * esperar_cualquiera: reparte trabajo entre varios hijos "trabajador" y
+ * recoge sus estados de salida sin sondear, espera a un hijo que muere
+ * por una excepcion y comprueba que no se puede esperar a quien no es hijo.
+ */
+
+#include "servicios.h"
+
+#define NUM_HIJOS 4
+
+int main(){
+	int ids[NUM_HIJOS];
+	int n, id, estado;
+
+	printf("prueba_esperar: comienza\n");
+
+	n=crear_procesos("trabajador", NUM_HIJOS, ids);
+	printf("prueba_esperar: %d hijos creados\n", n);
+
+	/* primero uno concreto, aunque no sea el primero en acabar */
+	if (esperar_proceso(ids[NUM_HIJOS-1], &estado)==0)
+		printf("prueba_esperar: hijo %d termino con %d\n", ids[NUM_HIJOS-1], estado);
+
+	/* despues el resto, en el orden en que terminen */
+	while ((id=esperar_cualquiera(&estado))>=0)
+		printf("prueba_esperar: hijo %d termino con %d\n", id, estado);
+	printf("prueba_esperar: no quedan hijos\n");
+
+	id=crear_proceso("excep_arit");
+	if (esperar_proceso(id, &estado)==0)
+		printf("prueba_esperar: excep_arit (%d) termino con %d\n", id, estado);
+
+	if (esperar_proceso(obtener_id_pr(), &estado)<0)
+		printf("prueba_esperar: no puede esperarse a si mismo. DEBE APARECER\n");
+
+	printf("prueba_esperar: termina\n");
+	return 0;
+}
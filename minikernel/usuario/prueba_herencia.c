@@ -0,0 +1,49 @@
+/*
+ * usuario/prueba_herencia.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que muestra la herencia de prioridad de los mutex
+ * (requiere compilar el kernel con PLANIFICACION=PLANIF_PRIO). Crea un
+ * proceso de prioridad baja que coge el mutex "m_pi" y calcula con el, y
+ * cuando lo tiene crea uno de prioridad media que solo calcula y otro de
+ * prioridad alta que pide el mutex. Sin herencia el de prioridad media
+ * retrasaria al de baja y con el al de alta todo lo que dura su calculo;
+ * con ella el de alta solo espera a que el de baja acabe su seccion.
+ */
+
+#include "servicios.h"
+
+int main(){
+	int bajo, medio, alto, seccion, calculo, espera;
+
+	if (fijar_prioridad(0)<0){
+		printf("prueba_herencia: el kernel no usa PLANIF_PRIO\n");
+		return 1;
+	}
+	if (crear_mutex("m_pi", NO_RECURSIVO)<0){
+		printf("prueba_herencia: error creando mutex\n");
+		return 1;
+	}
+
+	bajo=crear_proceso("herencia_bajo");
+	dormir(1);		/* el de prioridad baja entra en su seccion critica */
+	medio=crear_proceso("herencia_medio");
+	alto=crear_proceso("herencia_alto");
+
+	esperar_proceso(alto, &espera);
+	esperar_proceso(medio, &calculo);
+	esperar_proceso(bajo, &seccion);
+
+	printf("prueba_herencia: seccion critica de baja: %d ticks\n", seccion);
+	printf("prueba_herencia: calculo de media: %d ticks\n", calculo);
+	printf("prueba_herencia: espera de alta por el mutex: %d ticks\n", espera);
+	if (espera<calculo)
+		printf("prueba_herencia: inversion acotada: alta solo espera a la seccion de baja\n");
+	else
+		printf("prueba_herencia: inversion NO acotada: alta ha esperado al calculo de media\n");
+	return 0;
+}
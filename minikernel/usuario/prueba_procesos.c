@@ -0,0 +1,124 @@
+/*
+ * usuario/prueba_procesos.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que prueba la tabla de procesos dinamica: crea
+ * muchos mas procesos que la dimension inicial de la tabla y comprueba
+ * con listar_procesos que todos existen con ids distintos. Despues crea
+ * y espera un proceso breve, y crea otros hasta que uno recibe la misma
+ * entrada de la tabla; su id debe ser distinto y el antiguo ya no debe
+ * ser valido.
+ */
+
+#include "servicios.h"
+
+#define NUM_HIJOS 2000
+#define MAX_IDS (NUM_HIJOS+64)		/* holgura para init y otros procesos vivos */
+
+static int ids[MAX_IDS];
+static volatile int padre_activo=0;
+
+/* Deja en v los ids de todos los procesos vivos; -1 si no caben */
+static int listar(int *v){
+	int n;
+
+	n=listar_procesos(v, MAX_IDS);
+	if (n>MAX_IDS){
+		printf("prueba_procesos: %d procesos no caben en la lista\n", n);
+		return -1;
+	}
+	return n;
+}
+
+/* Crea un proceso breve de este mismo programa y devuelve su id */
+static int crear_breve(){
+	int id;
+
+	if (crear_procesos("prueba_procesos", 1, &id)!=1)
+		return -1;
+	return id;
+}
+
+static int comprobar_reutilizacion(){
+	estadisticas_proceso est;
+	int primero, siguiente=-1, intentos, estado, res=0;
+
+	/* al esperarlo, su entrada vuelve a la lista de libres */
+	if ((primero=crear_breve())<0 || esperar_proceso(primero, &estado)<0){
+		printf("prueba_procesos: ERROR, no se ha podido crear el proceso breve\n");
+		return -1;
+	}
+	printf("prueba_procesos: el primero tiene id %d (entrada %d)\n",
+		primero, primero & MASCARA_RANURA);
+
+	/* la entrada se da de nuevo cuando se agotan las que estaban libres */
+	for (intentos=1; intentos<=MAX_RANURAS; intentos++){
+		if ((siguiente=crear_breve())<0)
+			break;
+		if ((siguiente & MASCARA_RANURA)==(primero & MASCARA_RANURA))
+			break;
+		esperar_proceso(siguiente, &estado);
+		siguiente=-1;
+	}
+	if (siguiente<0){
+		printf("prueba_procesos: ERROR, no se ha reutilizado la entrada %d\n",
+			primero & MASCARA_RANURA);
+		return -1;
+	}
+	printf("prueba_procesos: tras %d procesos, id %d en la misma entrada\n",
+		intentos, siguiente);
+
+	if (siguiente==primero){
+		printf("prueba_procesos: ERROR, se ha repetido el id %d\n", primero);
+		res=-1;
+	}
+	else if (obtener_estadisticas(primero, &est)!=-1){
+		printf("prueba_procesos: ERROR, el id antiguo %d sigue siendo valido\n", primero);
+		res=-1;
+	}
+	else if (obtener_estadisticas(siguiente, &est)!=0){
+		printf("prueba_procesos: ERROR, el id nuevo %d no es valido\n", siguiente);
+		res=-1;
+	}
+	else
+		printf("prueba_procesos: correcto, ids distintos (%d y %d) y el antiguo no es valido\n",
+			primero, siguiente);
+	esperar_proceso(siguiente, &estado);
+	return res;
+}
+
+int main(){
+	int creados, n, i, j, repetidos=0, res;
+
+	if (padre_activo)
+		return 0;	/* proceso breve */
+
+	padre_activo=1;
+	printf("prueba_procesos: comienza\n");
+
+	for (creados=0; creados<NUM_HIJOS; creados++)
+		if (crear_proceso("durmiente")<0)
+			break;
+	printf("prueba_procesos: %d procesos creados\n", creados);
+
+	if ((n=listar(ids))<0){
+		padre_activo=0;
+		return 1;
+	}
+	for (i=0; i<n; i++)
+		for (j=i+1; j<n; j++)
+			if (ids[i]==ids[j])
+				repetidos++;
+	printf("prueba_procesos: %d procesos existentes, %d ids repetidos: %s\n",
+		n, repetidos, repetidos==0 ? "correcto" : "ERROR");
+
+	res=comprobar_reutilizacion();
+
+	printf("prueba_procesos: termina\n");
+	padre_activo=0;	/* la imagen puede seguir en la cache */
+	return (repetidos==0 && res==0) ? 0 : 1;
+}
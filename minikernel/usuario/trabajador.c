@@ -0,0 +1,27 @@
+/*
+ * usuario/trabajador.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que hace un calculo que depende de su id y termina
+ * devolviendo el resultado como estado de salida. Lo usa prueba_esperar.
+ */
+
+#include "servicios.h"
+
+#define TOT_ITER 1000000
+
+int main(){
+	int i, id, suma=0;
+
+	id=obtener_id_pr();
+	for (i=0; i<TOT_ITER*(id%4+1); i++)
+		suma=(suma+i)%1000;
+
+	printf("trabajador (%d): termina con %d\n", id, suma%100+id);
+	salir(suma%100+id);
+	return 0;	/* no deberia llegar aqui */
+}
@@ -0,0 +1,28 @@
+/*
+ * usuario/volcar_traza.c
+ *
+ *  Minikernel. Version 2.0
+ *
+ */
+
+/*
+ * Programa de usuario que vacia el buffer de traza del kernel y escribe
+ * cada evento en una linea "EV secuencia tick tipo id arg valor", formato
+ * que herramientas/traza2json convierte al de chrome://tracing.
+ */
+
+#include "servicios.h"
+
+static evento_traza eventos[TAM_TRAZA];
+
+int main(){
+	int i, n;
+
+	/* Se vacia de una vez para no trazar las propias escrituras */
+	n=leer_traza(eventos, TAM_TRAZA);
+	for (i=0; i<n; i++)
+		printf("EV %lu %lu %d %d %d %ld\n", eventos[i].secuencia,
+			eventos[i].tick, eventos[i].tipo, eventos[i].id,
+			eventos[i].arg, eventos[i].valor);
+	return 0;
+}